@@ -0,0 +1,371 @@
+/*
+ * File: corpusGenerator.cpp
+ * Project: Lexer
+ * Author: MingLLuo
+ * Usage: Define the CorpusGenerator class
+ */
+#include "corpusGenerator.h"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+/* parseSize: a byte count with an optional K, M or G suffix (powers of
+ * 1024), as in 64M
+ */
+size_t parseSize(const std::string &text) {
+    size_t end = 0;
+    size_t value = std::stoull(text, &end);
+    std::string suffix = text.substr(end);
+    if (suffix == "K" || suffix == "k")
+        return value << 10;
+    if (suffix == "M" || suffix == "m")
+        return value << 20;
+    if (suffix == "G" || suffix == "g")
+        return value << 30;
+    if (!suffix.empty())
+        throw std::invalid_argument("bad size " + text);
+    return value;
+}
+
+/* trim: s without the spaces around it */
+static std::string trim(const std::string &s) {
+    size_t begin = s.find_first_not_of(' ');
+    if (begin == std::string::npos)
+        return "";
+    return s.substr(begin, s.find_last_not_of(' ') - begin + 1);
+}
+
+/* CorpusGenerator: read the rules of pattern, a terminal is a keyword, a
+ * symbol, identifier or number, split from its neighbours the way the
+ * parser of task2 splits them ("(exp)" is ( exp ))
+ * @param pattern: pattern file with a rules section
+ */
+CorpusGenerator::CorpusGenerator(const Pattern &pattern,
+                                 CorpusOptions options)
+    : options(options), lcomment(pattern.lcomment),
+      rcomment(pattern.rcomment), comment(pattern.comment),
+      letters(pattern.letters), digits(pattern.digits),
+      fractions(pattern.numRegex.find('.') != std::string::npos) {
+    for (const auto &rule : pattern.rules) {
+        std::string name = trim(rule.first);
+        symbols[name] = static_cast<uint32_t>(rules.size());
+        bool voidFree = options.parserSafe &&
+                        (name == "parameter" || name == "variable-definition");
+        rules.push_back({name, {}, {}, {}, voidFree});
+    }
+    identifier = symbolOf("identifier");
+    number = symbolOf("number");
+    for (const auto &rule : pattern.rules) {
+        uint32_t lhs = symbols.at(trim(rule.first));
+        for (const auto &text : rule.second) {
+            Alternative alternative;
+            std::istringstream iss(text);
+            std::string piece;
+            while (std::getline(iss, piece, ' ')) {
+                if (!piece.empty())
+                    splitPiece(pattern, piece, alternative.symbols);
+            }
+            if (alternative.symbols.empty())
+                continue;
+            const auto &members = alternative.symbols;
+            auto holds = [&](uint32_t symbol) {
+                return std::find(members.begin(), members.end(), symbol) !=
+                       members.end();
+            };
+            alternative.weight =
+                (holds(identifier) ? options.identifiers : 1) *
+                (holds(number) ? options.numbers : 1);
+            if (alternative.symbols.front() == lhs) {
+                alternative.symbols.erase(alternative.symbols.begin());
+                rules[lhs].tails.push_back(std::move(alternative));
+            } else {
+                rules[lhs].bases.push_back(std::move(alternative));
+            }
+        }
+    }
+    std::string startName = pattern.start.empty() ? "program" : pattern.start;
+    if (symbols.count(startName) == 0 || symbols[startName] >= rules.size())
+        throw std::runtime_error("no rule for start symbol " + startName);
+    start = symbols[startName];
+    if (symbols.count("void") != 0 && symbols["void"] >= rules.size())
+        voidType = symbols["void"];
+    computeShortest();
+
+    // identifiers: a letter then letters and digits, never a keyword
+    std::mt19937 nameRandom(options.seed);
+    std::uniform_int_distribution<size_t> length(2, 8);
+    std::set<std::string> seen;
+    for (size_t tries = 0; names.size() < options.names && tries < 100;) {
+        std::string name(1, letters[nameRandom() % letters.size()]);
+        for (size_t i = length(nameRandom); name.size() < i;) {
+            size_t pick = nameRandom() % (letters.size() + digits.size());
+            name += pick < letters.size() ? letters[pick]
+                                          : digits[pick - letters.size()];
+        }
+        if (pattern.isKeyword(name) || !seen.insert(name).second) {
+            tries++;
+            continue;
+        }
+        tries = 0;
+        names.push_back(name);
+    }
+    if (names.empty())
+        throw std::runtime_error("no identifier can be generated");
+}
+
+/* symbolOf: the symbol of a rule or terminal name, a terminal seen for the
+ * first time is added
+ */
+uint32_t CorpusGenerator::symbolOf(const std::string &name) {
+    auto it = symbols.find(name);
+    if (it != symbols.end())
+        return it->second;
+    auto symbol = static_cast<uint32_t>(rules.size() + terminals.size());
+    terminals.push_back(name);
+    symbols[name] = symbol;
+    return symbol;
+}
+
+/* splitPiece: append the symbols of one space separated piece of a rule
+ * @param symbols: symbols of the alternative so far
+ */
+void CorpusGenerator::splitPiece(const Pattern &pattern,
+                                 const std::string &piece,
+                                 std::vector<uint32_t> &symbols) {
+    if (this->symbols.count(piece) != 0 || pattern.isKeyword(piece) ||
+        pattern.isSpecialSymbol(piece)) {
+        symbols.push_back(symbolOf(piece));
+    } else if (piece.size() > 2 && piece.front() == '(' &&
+               piece.back() == ')') {
+        symbols.push_back(symbolOf("("));
+        splitPiece(pattern, piece.substr(1, piece.size() - 2), symbols);
+        symbols.push_back(symbolOf(")"));
+    } else if (pattern.isSpecialSymbol(piece.substr(0, 1))) {
+        symbols.push_back(symbolOf(piece.substr(0, 1)));
+        splitPiece(pattern, piece.substr(1), symbols);
+    } else {
+        throw std::runtime_error("unknown grammar symbol " + piece);
+    }
+}
+
+/* computeShortest: order the bases of every rule by the depth of their
+ * shallowest derivation, then by its token count, which is what maxDepth
+ * falls back to; bases that never terminate are left out
+ */
+void CorpusGenerator::computeShortest() {
+    std::vector<size_t> height(rules.size(), SIZE_MAX);
+    std::vector<size_t> tokens(rules.size(), SIZE_MAX);
+    // depth and token count of the shortest derivation of an alternative
+    auto measure = [&](const Alternative &alternative) {
+        size_t h = 0, count = 0;
+        for (uint32_t symbol : alternative.symbols) {
+            if (symbol >= rules.size()) {
+                count++;
+            } else if (height[symbol] == SIZE_MAX) {
+                return std::make_pair(SIZE_MAX, SIZE_MAX);
+            } else {
+                h = std::max(h, height[symbol]);
+                count += tokens[symbol];
+            }
+        }
+        return std::make_pair(h + 1, count);
+    };
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (size_t i = 0; i < rules.size(); i++) {
+            for (const auto &base : rules[i].bases) {
+                auto [h, count] = measure(base);
+                if (h < height[i] || (h == height[i] && count < tokens[i])) {
+                    height[i] = h;
+                    tokens[i] = count;
+                    changed = true;
+                }
+            }
+        }
+    }
+    for (size_t i = 0; i < rules.size(); i++) {
+        if (height[i] == SIZE_MAX)
+            throw std::runtime_error("rule " + rules[i].name +
+                                     " derives no program");
+        std::vector<std::pair<std::pair<size_t, size_t>, size_t>> order;
+        for (size_t j = 0; j < rules[i].bases.size(); j++) {
+            auto key = measure(rules[i].bases[j]);
+            if (key.first != SIZE_MAX)
+                order.push_back({key, j});
+        }
+        std::stable_sort(order.begin(), order.end());
+        for (const auto &entry : order)
+            rules[i].shortest.push_back(entry.second);
+    }
+}
+
+/* generate: derive one program of at least bytes bytes; it ends after the
+ * element of the start symbol's list that reaches the size
+ * @param sink: called with the text in chunks of about 1 MB
+ */
+void CorpusGenerator::generate(size_t bytes, const Sink &sink) {
+    random.seed(options.seed);
+    this->sink = &sink;
+    buffer.clear();
+    written = 0;
+    lineLength = 0;
+    voidFreeDepth = 0;
+    bracketDepth = 0;
+    budget = std::max<size_t>(bytes, 1);
+    expand(start, 0);
+    if (lineLength > 0)
+        buffer += '\n';
+    flush();
+    this->sink = nullptr;
+}
+
+/* generate: derive one program of at least bytes bytes, in memory */
+std::string CorpusGenerator::generate(size_t bytes) {
+    std::string result;
+    result.reserve(bytes + bytes / 16);
+    generate(bytes, [&](std::string_view chunk) { result += chunk; });
+    return result;
+}
+
+/* expand: derive symbol; the first list rule met takes the budget and
+ * repeats its tail until the program is large enough, other lists get a
+ * geometric number of tails
+ */
+void CorpusGenerator::expand(uint32_t symbol, int depth) {
+    if (symbol >= rules.size()) {
+        if (symbol == identifier) {
+            emit(names[random() % names.size()]);
+        } else if (symbol == number) {
+            std::string digitsText(1 + random() % 5, ' ');
+            for (char &c : digitsText)
+                c = digits[random() % digits.size()];
+            bool integer = options.parserSafe && bracketDepth > 0;
+            if (fractions && !integer && random() % 4 == 0) {
+                digitsText += '.';
+                digitsText += digits[random() % digits.size()];
+            }
+            emit(digitsText);
+        } else {
+            const std::string &text = terminals[symbol - rules.size()];
+            bracketDepth += (text == "[") - (text == "]");
+            emit(text);
+        }
+        return;
+    }
+    const Rule &rule = rules[symbol];
+    size_t target = 0;
+    if (budget > 0 && !rule.tails.empty())
+        std::swap(target, budget);
+    voidFreeDepth += rule.voidFree;
+    bool deep = depth >= options.maxDepth;
+    if (deep) {
+        // the shortest base that is allowed here, else the shortest
+        size_t pick = rule.shortest.front();
+        for (size_t index : rule.shortest) {
+            if (allowed(rule.bases[index])) {
+                pick = index;
+                break;
+            }
+        }
+        expandAll(rule.bases[pick], depth + 1);
+    } else {
+        expandAll(choose(rule.bases), depth + 1);
+    }
+    if (target > 0) {
+        while (written + buffer.size() < target)
+            expandAll(choose(rule.tails), depth + 1);
+    } else if (!deep && !rule.tails.empty()) {
+        while (random() % 2 == 0)
+            expandAll(choose(rule.tails), depth + 1);
+    }
+    voidFreeDepth -= rule.voidFree;
+}
+
+/* expandAll: derive every symbol of an alternative in order */
+void CorpusGenerator::expandAll(const Alternative &alternative, int depth) {
+    for (uint32_t symbol : alternative.symbols) {
+        expand(symbol, depth);
+    }
+}
+
+/* allowed: alternative may be derived here, it holds no void inside a
+ * voidFree rule
+ */
+bool CorpusGenerator::allowed(const Alternative &alternative) const {
+    if (voidFreeDepth == 0 || voidType == NONE)
+        return true;
+    const auto &members = alternative.symbols;
+    return std::find(members.begin(), members.end(), voidType) ==
+           members.end();
+}
+
+/* choose: a random allowed alternative by weight, the first allowed one if
+ * all weigh 0, the first if none is allowed
+ */
+const CorpusGenerator::Alternative &
+CorpusGenerator::choose(const std::vector<Alternative> &alternatives) {
+    double total = 0;
+    const Alternative *first = nullptr;
+    for (const auto &alternative : alternatives) {
+        if (allowed(alternative)) {
+            total += alternative.weight;
+            first = first != nullptr ? first : &alternative;
+        }
+    }
+    if (first == nullptr)
+        return alternatives.front();
+    if (total <= 0)
+        return *first;
+    double pick = std::uniform_real_distribution<double>(0, total)(random);
+    for (const auto &alternative : alternatives) {
+        if (!allowed(alternative))
+            continue;
+        if (pick < alternative.weight)
+            return alternative;
+        pick -= alternative.weight;
+    }
+    return *first;
+}
+
+/* emit: append a token, a line ends after ; { } or past 72 columns */
+void CorpusGenerator::emit(const std::string &token) {
+    if (lineLength > 0) {
+        buffer += ' ';
+        lineLength++;
+    }
+    buffer += token;
+    lineLength += token.size();
+    if (token == ";" || token == "{" || token == "}" || lineLength >= 72)
+        newLine();
+}
+
+/* newLine: end the line, then maybe put a comment line of a few names */
+void CorpusGenerator::newLine() {
+    buffer += '\n';
+    lineLength = 0;
+    bool hasComment = !lcomment.empty() || !comment.empty();
+    std::uniform_real_distribution<double> chance(0, 1);
+    if (hasComment && chance(random) < options.comments) {
+        buffer += lcomment.empty() ? comment : lcomment;
+        for (size_t i = 1 + random() % 8; i > 0; i--) {
+            buffer += ' ';
+            buffer += names[random() % names.size()];
+        }
+        if (lcomment.empty()) {
+            buffer += '\n';
+        } else {
+            buffer += ' ' + rcomment + '\n';
+        }
+    }
+    if (buffer.size() >= (1 << 20))
+        flush();
+}
+
+/* flush: hand the buffered text to the sink */
+void CorpusGenerator::flush() {
+    if (buffer.empty())
+        return;
+    (*sink)(buffer);
+    written += buffer.size();
+    buffer.clear();
+}
@@ -0,0 +1,113 @@
+/*
+ * File: corpusGenerator.h
+ * Project: Lexer
+ * Author: MingLLuo
+ * Usage: Define the CorpusGenerator class, random programs of a grammar
+ */
+#ifndef LEXICAL_CORPUSGENERATOR_H
+#define LEXICAL_CORPUSGENERATOR_H
+
+#include "../src/pattern.h"
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string_view>
+
+/* CorpusOptions: shape of the generated programs
+ * comments: chance of a comment before each line
+ * identifiers, numbers: weight of an alternative that holds an identifier
+ * or a number, against 1 for the others; 0 avoids them where it can
+ * names: distinct identifiers used
+ * maxDepth: nesting depth past which the shortest alternative is taken,
+ * the shallowest derivation with the fewest tokens
+ * parserSafe: only programs the SLR(1) parser of task2 accepts; its table
+ * reduces "( void" to an empty parameter list, so void is kept out of
+ * parameter and variable-definition, and numbers between [ ] are integers
+ */
+struct CorpusOptions {
+    double comments = 0.1;
+    double identifiers = 1;
+    double numbers = 1;
+    size_t names = 1000;
+    int maxDepth = 16;
+    uint32_t seed = 1;
+    bool parserSafe = true;
+};
+
+/* CorpusGenerator: derives programs from the rules of a pattern file, as
+ * read by the parser of task2; the tokens are separated by spaces and
+ * newlines so the lexer of the same file splits them back. A left
+ * recursive rule X -> X a | b is derived as b a a ..., the list of the
+ * start symbol repeated until the program has the size asked for, so
+ * memory and recursion stay bounded by the nesting depth
+ */
+class CorpusGenerator {
+  public:
+    using Sink = std::function<void(std::string_view chunk)>;
+
+    explicit CorpusGenerator(const Pattern &pattern,
+                             CorpusOptions options = {});
+
+    void generate(size_t bytes, const Sink &sink);
+    std::string generate(size_t bytes);
+
+  private:
+    // a symbol below rules.size() is a nonterminal, else a terminal
+    struct Alternative {
+        std::vector<uint32_t> symbols;
+        double weight = 1;
+    };
+    // bases derive X, tails are the a of X -> X a
+    struct Rule {
+        std::string name;
+        std::vector<Alternative> bases;
+        std::vector<Alternative> tails;
+        // indexes of the bases that terminate, shortest first
+        std::vector<size_t> shortest;
+        bool voidFree = false;
+    };
+
+    uint32_t symbolOf(const std::string &name);
+    void splitPiece(const Pattern &pattern, const std::string &piece,
+                    std::vector<uint32_t> &symbols);
+    void computeShortest();
+    void expand(uint32_t symbol, int depth);
+    void expandAll(const Alternative &alternative, int depth);
+    const Alternative &choose(const std::vector<Alternative> &alternatives);
+    [[nodiscard]] bool allowed(const Alternative &alternative) const;
+    void emit(const std::string &token);
+    void newLine();
+    void flush();
+
+    CorpusOptions options;
+    std::string lcomment, rcomment, comment;
+    std::vector<Rule> rules;
+    std::vector<std::string> terminals;
+    std::map<std::string, uint32_t> symbols;
+    uint32_t start = 0;
+    uint32_t identifier = 0;
+    uint32_t number = 0;
+    // the void terminal, NONE if the grammar has none
+    static constexpr uint32_t NONE = UINT32_MAX;
+    uint32_t voidType = NONE;
+    std::vector<std::string> names;
+    std::vector<char> letters, digits;
+    // the number regex has a fraction part
+    bool fractions = false;
+
+    // state of one generate call
+    std::mt19937 random;
+    const Sink *sink = nullptr;
+    std::string buffer;
+    size_t written = 0;
+    size_t lineLength = 0;
+    // voidFree rules being expanded, and [ not closed yet
+    int voidFreeDepth = 0;
+    int bracketDepth = 0;
+    // size of the program the start symbol's list grows to, taken once
+    size_t budget = 0;
+};
+
+size_t parseSize(const std::string &text);
+
+#endif // LEXICAL_CORPUSGENERATOR_H
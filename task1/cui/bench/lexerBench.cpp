@@ -0,0 +1,301 @@
+/*
+ * File: lexerBench.cpp
+ * Project: Lexer
+ * Author: MingLLuo
+ * Usage: Benchmark of lexer construction, time, peak RSS and state counts
+ *        of every stage as the patterns grow
+ *
+ * lexer_bench [--format csv|json] [--out FILE] [--dir DIR] [--max N]
+ *             [--max-nth N]
+ *
+ * Three families of cases, each swept over its size:
+ *  keywords: a pattern file with size keywords and size symbols, written to
+ *    DIR; the final NFA is built as lexerInit does (literal tries and the
+ *    id, num and comment regexes), then the whole lexerInit is timed
+ *  literal: a regex of size escaped bytes, a concatenation
+ *  nth: (a|b)*a(a|b)...(a|b) with size - 1 copies, whose DFA has 2^size
+ *    states before minimization
+ * One row per stage: family, size, stage, ms, states (of the automaton the
+ * stage built, 0 for parsing) and peakRssKB (peak during the stage where
+ * the kernel can reset it, else of the process so far; either way it
+ * includes the heap the allocator kept from earlier cases)
+ */
+#include "../src/lexer.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sys/resource.h>
+#include <unordered_set>
+
+struct BenchRow {
+    std::string family;
+    size_t size;
+    std::string stage;
+    double ms;
+    size_t states;
+    long peakRssKB;
+};
+
+/* resetPeakRss: start a new peak RSS measurement, Linux only
+ * @return: false if the peak cannot be reset
+ */
+static bool resetPeakRss() {
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+    clearRefs.flush();
+    return static_cast<bool>(clearRefs);
+}
+
+/* peakRss: peak resident set size in KB since the last reset, or since the
+ * process started if there is no /proc
+ */
+static long peakRss() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) {
+            return std::stol(line.substr(6));
+        }
+    }
+    struct rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+class Bench {
+  public:
+    std::vector<BenchRow> rows;
+
+    /* measure: run one stage and record its row
+     * @param f: the stage, returns its state count
+     */
+    template <typename F>
+    void measure(const std::string &family, size_t size,
+                 const std::string &stage, F &&f) {
+        resetPeakRss();
+        auto begin = std::chrono::steady_clock::now();
+        size_t states = f();
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - begin;
+        rows.push_back({family, size, stage, elapsed.count(), states,
+                        peakRss()});
+        std::cerr << family << " " << size << " " << stage << " "
+                  << elapsed.count() << " ms" << std::endl;
+    }
+
+    /* regexCase: time every stage of one regex, from text to minimal DFA */
+    void regexCase(const std::string &family, size_t size,
+                   const std::string &regex) {
+        std::shared_ptr<RegExp> regExp;
+        std::shared_ptr<NFA> nfa;
+        std::shared_ptr<DFA> dfa;
+        measure(family, size, "stringToRegExp", [&] {
+            regExp = stringToRegExp(regex);
+            return size_t{0};
+        });
+        measure(family, size, "toNFA", [&] {
+            nfa = regExp->toNFA();
+            return nfa->states.size();
+        });
+        measure(family, size, "convertToDFA", [&] {
+            dfa = convertToDFA(nfa);
+            return dfa->dfa_states.size();
+        });
+        measure(family, size, "minimizeDFA", [&] {
+            return dfa->minimizeDFA()->dfa_states.size();
+        });
+    }
+
+    void keywordsCase(size_t size, const std::string &path);
+
+    void writeCsv(std::ostream &out) const;
+    void writeJson(std::ostream &out) const;
+};
+
+/* keywordsCase: time the stages of the final DFA of a pattern file, then
+ * lexerInit on it with no cache
+ * @param path: generated pattern file
+ */
+void Bench::keywordsCase(size_t size, const std::string &path) {
+    const std::string family = "keywords";
+    Lexer lexer;
+    lexer.pattern = Pattern("", path);
+    const Pattern &pattern = lexer.pattern;
+
+    std::map<std::string, std::shared_ptr<RegExp>> regExps;
+    measure(family, size, "stringToRegExp", [&] {
+        regExps["id"] = stringToRegExp(pattern.idRegexToRegScanner());
+        regExps["num"] = stringToRegExp(pattern.numRegexToRegScanner());
+        regExps["comment"] = stringToRegExp(pattern.commentRegexToRegScanner());
+        return size_t{0};
+    });
+    std::shared_ptr<NFA> nfa;
+    measure(family, size, "literalTrieNFA", [&] {
+        auto keywords = pattern.keywordsToRegScanner();
+        auto symbols = pattern.specialSymbolsToRegScanner();
+        nfa = unionNFAs(literalTrieNFA(keywords, keywords),
+                        literalTrieNFA(symbols, symbols));
+        return nfa->states.size();
+    });
+    measure(family, size, "toNFA", [&] {
+        for (const char *name : {"id", "num", "comment"}) {
+            auto part = regExps[name]->toNFA();
+            part->setFinalStatus(name);
+            nfa = unionNFAs(nfa, part);
+        }
+        return nfa->states.size();
+    });
+    std::shared_ptr<DFA> dfa;
+    measure(family, size, "convertToDFA", [&] {
+        dfa = convertToDFA(nfa);
+        return dfa->dfa_states.size();
+    });
+    measure(family, size, "minimizeDFA", [&] {
+        return dfa->minimizeDFA()->dfa_states.size();
+    });
+    dfa = nullptr;
+    nfa = nullptr;
+    measure(family, size, "lexerInit", [&] {
+        lexer.lexerInit();
+        return lexer.finalDFA->dfa_states.size();
+    });
+}
+
+/* writeCsv: the rows with a header line */
+void Bench::writeCsv(std::ostream &out) const {
+    out << "family,size,stage,ms,states,peakRssKB\n";
+    for (const auto &row : rows) {
+        out << row.family << "," << row.size << "," << row.stage << ","
+            << row.ms << "," << row.states << "," << row.peakRssKB << "\n";
+    }
+}
+
+/* writeJson: the rows as an array of objects */
+void Bench::writeJson(std::ostream &out) const {
+    out << "[\n";
+    for (size_t i = 0; i < rows.size(); i++) {
+        const auto &row = rows[i];
+        out << "  {\"family\": \"" << row.family << "\", \"size\": "
+            << row.size << ", \"stage\": \"" << row.stage
+            << "\", \"ms\": " << row.ms << ", \"states\": " << row.states
+            << ", \"peakRssKB\": " << row.peakRssKB << "}"
+            << (i + 1 < rows.size() ? ",\n" : "\n");
+    }
+    out << "]\n";
+}
+
+/* writePatterns: a pattern file in the format of patterns.txt with count
+ * distinct keywords (random words, fixed seed) and count distinct symbols
+ * (every string over the operator bytes, shortest first)
+ * @param path: file to write
+ */
+static void writePatterns(const std::string &path, size_t count) {
+    std::mt19937 random(count);
+    std::uniform_int_distribution<int> length(3, 10), letter('a', 'z');
+    std::unordered_set<std::string> seen;
+    std::string keywords;
+    while (seen.size() < count) {
+        std::string word(length(random), ' ');
+        for (char &c : word) {
+            c = static_cast<char>(letter(random));
+        }
+        if (seen.insert(word).second) {
+            keywords += " " + word;
+        }
+    }
+
+    const std::string alphabet = "+-*/%<>=!&|^~";
+    std::string symbols;
+    std::vector<size_t> digits;
+    for (size_t i = 0; i < count; i++) {
+        // next string of the enumeration, digits are indexes in alphabet
+        size_t pos = 0;
+        while (pos < digits.size() && ++digits[pos] == alphabet.size()) {
+            digits[pos++] = 0;
+        }
+        if (pos == digits.size()) {
+            digits.push_back(0);
+        }
+        symbols += " ";
+        for (size_t digit : digits) {
+            symbols += alphabet[digit];
+        }
+    }
+
+    std::ofstream file(path);
+    file << "keywords:" << keywords << "\n"
+         << "symbols:" << symbols << "\n"
+         << "lcomment: {\n"
+         << "rcomment: }\n"
+         << "identifier: (_|l)(_|l|d)*\n"
+         << "number: dd*(.dd*)?\n";
+}
+
+int main(int argc, char *argv[]) {
+    std::string format = "csv", outPath, dir = "bench_patterns";
+    size_t maxCount = 100000, maxNth = 16;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 == argc) {
+            std::cerr << "missing value of " << arg << std::endl;
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--format" && (value == "csv" || value == "json")) {
+            format = value;
+        } else if (arg == "--out") {
+            outPath = value;
+        } else if (arg == "--dir") {
+            dir = value;
+        } else if (arg == "--max") {
+            maxCount = std::stoul(value);
+        } else if (arg == "--max-nth") {
+            maxNth = std::stoul(value);
+        } else {
+            std::cerr << "usage: lexer_bench [--format csv|json] [--out FILE]"
+                         " [--dir DIR] [--max N] [--max-nth N]"
+                      << std::endl;
+            return 1;
+        }
+    }
+    if (!resetPeakRss()) {
+        std::cerr << "peak RSS cannot be reset, it is reported for the "
+                     "whole process"
+                  << std::endl;
+    }
+
+    Bench bench;
+    std::filesystem::create_directories(dir);
+    for (size_t count = 10; count <= maxCount; count *= 10) {
+        std::string path = dir + "/keywords" + std::to_string(count) + ".txt";
+        writePatterns(path, count);
+        bench.keywordsCase(count, path);
+    }
+    for (size_t length = 10; length <= maxCount / 10; length *= 10) {
+        std::string literal;
+        for (size_t i = 0; i < length; i++) {
+            literal += static_cast<char>('a' + i % 26);
+        }
+        bench.regexCase("literal", length, escapeRegex(literal));
+    }
+    for (size_t n = 2; n <= maxNth; n += 2) {
+        std::string regex = "(a|b)*a";
+        for (size_t i = 1; i < n; i++) {
+            regex += "(a|b)";
+        }
+        bench.regexCase("nth", n, regex);
+    }
+
+    std::ofstream file;
+    if (!outPath.empty()) {
+        file.open(outPath);
+    }
+    std::ostream &out = outPath.empty() ? std::cout : file;
+    if (format == "json") {
+        bench.writeJson(out);
+    } else {
+        bench.writeCsv(out);
+    }
+    return 0;
+}
@@ -0,0 +1,81 @@
+/*
+ * File: lexerCorpus.cpp
+ * Project: Lexer
+ * Author: MingLLuo
+ * Usage: Write a generated program of a grammar, for lexer_throughput
+ *
+ * lexer_corpus --grammar FILE [--size SIZE] [--out FILE] [--comments P]
+ *              [--identifiers W] [--numbers W] [--names N] [--seed N]
+ *              [--parser-safe 0|1]
+ *
+ * FILE is a pattern file with rules, like task2/cui/test/tiny.txt; SIZE
+ * takes a K, M or G suffix (default 1M); the program goes to stdout
+ * unless --out is given. With --parser-safe 1 (the default) the program
+ * is one the SLR(1) parser of task2 accepts: no void in parameter or
+ * variable-definition, integers between [ ]; 0 derives the grammar as is
+ */
+#include "corpusGenerator.h"
+#include <iostream>
+
+int main(int argc, char *argv[]) {
+    std::string grammar, outPath;
+    size_t size = 1 << 20;
+    CorpusOptions options;
+    try {
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string arg = argv[i], value = argv[i + 1];
+            if (arg == "--grammar") {
+                grammar = value;
+            } else if (arg == "--size") {
+                size = parseSize(value);
+            } else if (arg == "--out") {
+                outPath = value;
+            } else if (arg == "--comments") {
+                options.comments = std::stod(value);
+            } else if (arg == "--identifiers") {
+                options.identifiers = std::stod(value);
+            } else if (arg == "--numbers") {
+                options.numbers = std::stod(value);
+            } else if (arg == "--names") {
+                options.names = std::stoul(value);
+            } else if (arg == "--seed") {
+                options.seed = std::stoul(value);
+            } else if (arg == "--parser-safe") {
+                options.parserSafe = std::stoi(value) != 0;
+            } else {
+                grammar.clear();
+                break;
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    if (grammar.empty() || argc % 2 == 0) {
+        std::cerr << "usage: lexer_corpus --grammar FILE [--size SIZE]"
+                     " [--out FILE] [--comments P] [--identifiers W]"
+                     " [--numbers W] [--names N] [--seed N]"
+                     " [--parser-safe 0|1]"
+                  << std::endl;
+        return 1;
+    }
+
+    try {
+        CorpusGenerator generator(Pattern("", grammar), options);
+        std::ofstream file;
+        if (!outPath.empty())
+            file.open(outPath, std::ios::binary);
+        std::ostream &out = outPath.empty() ? std::cout : file;
+        generator.generate(size, [&](std::string_view chunk) {
+            out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        });
+        if (!out) {
+            std::cerr << "cannot write the program" << std::endl;
+            return 1;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << grammar << ": " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
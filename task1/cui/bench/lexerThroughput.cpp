@@ -0,0 +1,249 @@
+/*
+ * File: lexerThroughput.cpp
+ * Project: Lexer
+ * Author: MingLLuo
+ * Usage: Tokenization throughput of every scanning engine of Lexer on
+ *        generated TINY and miniC programs
+ *
+ * lexer_throughput [--grammars DIR] [--lang tiny|minic|all] [--size SIZE]
+ *                  [--corpus FILE] [--repeat N] [--threads N]
+ *                  [--comments P] [--identifiers W] [--numbers W]
+ *                  [--seed N] [--parser-safe 0|1] [--format csv|json]
+ *                  [--out FILE]
+ *
+ * DIR holds tiny.txt and minic.txt (default ../../../task2/cui/test, from
+ * a build directory of task1/cui). Each language gets a program of SIZE
+ * bytes (default 64M) from its grammar, or FILE (read mapped, needs a
+ * single --lang) from lexer_corpus. Engines:
+ *  table: tokenize on the CompiledDFA
+ *  keywordHash: the same with keywords reclassified by the perfect hash
+ *  lazy: tokenize on a LazyDFA of 4096 states
+ *  parallel: tokenizeParallel on --threads chunks (0 for every core)
+ *  tokenStream: toTokenStream, lexemes interned; it holds every token,
+ *    about 30 bytes each, mind the memory on the largest inputs
+ * Every engine runs --repeat times (default 3) and the fastest run is
+ * reported: lang, engine, bytes, tokens, errors (tokens of no kind, 0
+ * for a generated program), seconds, MBps (2^20 bytes) and tokensPerSec
+ */
+#include "../src/lexer.h"
+#include "../src/mappedFile.h"
+#include "corpusGenerator.h"
+#include <chrono>
+
+struct ThroughputRow {
+    std::string lang;
+    std::string engine;
+    size_t bytes;
+    size_t tokens;
+    size_t errors;
+    double seconds;
+};
+
+/* Engine: a Lexer and how it scans the whole input, counting tokens */
+struct Engine {
+    std::string name;
+    LexerOptions options;
+    std::function<void(const Lexer &, std::string_view, size_t &,
+                       size_t &)>
+        run;
+};
+
+/* engines: every engine, parallel ones on threads chunks */
+static std::vector<Engine> engines(unsigned threads) {
+    auto tokenize = [](const Lexer &lexer, std::string_view input,
+                       size_t &tokens, size_t &errors) {
+        lexer.tokenize(input, [&](const LexToken &token, std::string_view) {
+            tokens++;
+            errors += token.kind == LexToken::ERROR_KIND;
+        });
+    };
+    auto parallel = [threads](const Lexer &lexer, std::string_view input,
+                              size_t &tokens, size_t &errors) {
+        lexer.tokenizeParallel(
+            input,
+            [&](const LexToken &token, std::string_view) {
+                tokens++;
+                errors += token.kind == LexToken::ERROR_KIND;
+            },
+            threads);
+    };
+    auto stream = [](const Lexer &lexer, std::string_view input,
+                     size_t &tokens, size_t &errors) {
+        TokenStream result = lexer.toTokenStream(input);
+        tokens = result.records.size();
+        for (const auto &record : result.records) {
+            errors += record.kind == TokenStream::ERROR_KIND;
+        }
+    };
+    return {{"table", LexerOptions{}, tokenize},
+            {"keywordHash", LexerOptions{"", true}, tokenize},
+            {"lazy", LexerOptions{"", false, 4096}, tokenize},
+            {"parallel", LexerOptions{}, parallel},
+            {"tokenStream", LexerOptions{}, stream}};
+}
+
+/* RowWriter: rows written as they are measured, CSV with a header line or
+ * a JSON array, so the engines done survive one running out of memory
+ */
+class RowWriter {
+  public:
+    RowWriter(std::ostream &out, std::string format)
+        : out(out), format(std::move(format)) {
+        if (this->format == "csv")
+            out << "lang,engine,bytes,tokens,errors,seconds,MBps,"
+                   "tokensPerSec\n";
+        else
+            out << "[";
+        out.flush();
+    }
+
+    ~RowWriter() {
+        if (format != "csv")
+            out << (count > 0 ? "\n]\n" : "]\n");
+    }
+
+    void write(const ThroughputRow &row) {
+        double mbps = row.bytes / row.seconds / (1 << 20);
+        double tokensPerSec = row.tokens / row.seconds;
+        if (format == "csv") {
+            out << row.lang << "," << row.engine << "," << row.bytes << ","
+                << row.tokens << "," << row.errors << "," << row.seconds
+                << "," << mbps << "," << tokensPerSec << "\n";
+        } else {
+            out << (count > 0 ? ",\n" : "\n") << "  {\"lang\": \""
+                << row.lang << "\", \"engine\": \"" << row.engine
+                << "\", \"bytes\": " << row.bytes
+                << ", \"tokens\": " << row.tokens
+                << ", \"errors\": " << row.errors
+                << ", \"seconds\": " << row.seconds << ", \"MBps\": " << mbps
+                << ", \"tokensPerSec\": " << tokensPerSec << "}";
+        }
+        out.flush();
+        count++;
+    }
+
+  private:
+    std::ostream &out;
+    std::string format;
+    size_t count = 0;
+};
+
+/* measure: the fastest of repeat runs of every engine over input
+ * @param patterns: pattern file of the language
+ */
+static void measure(const std::string &lang, const std::string &patterns,
+                    std::string_view input, unsigned threads, int repeat,
+                    RowWriter &writer) {
+    std::vector<ThroughputRow> rows;
+    for (const auto &engine : engines(threads)) {
+        Lexer lexer("", patterns, engine.options);
+        ThroughputRow row{lang, engine.name, input.size(), 0, 0, 0};
+        for (int i = 0; i < repeat; i++) {
+            size_t tokens = 0, errors = 0;
+            auto begin = std::chrono::steady_clock::now();
+            engine.run(lexer, input, tokens, errors);
+            std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - begin;
+            if (i == 0 || elapsed.count() < row.seconds)
+                row.seconds = elapsed.count();
+            row.tokens = tokens;
+            row.errors = errors;
+        }
+        if (!rows.empty() && rows.back().tokens != row.tokens) {
+            std::cerr << lang << ": " << engine.name << " found " << row.tokens
+                      << " tokens, " << rows.back().engine << " "
+                      << rows.back().tokens << std::endl;
+        }
+        std::cerr << lang << " " << engine.name << " " << row.seconds << " s"
+                  << std::endl;
+        writer.write(row);
+        rows.push_back(row);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::string grammars = "../../../task2/cui/test", lang = "all";
+    std::string corpus, format = "csv", outPath;
+    size_t size = 64 << 20;
+    unsigned threads = 0;
+    int repeat = 3;
+    CorpusOptions options;
+    bool usage = argc % 2 == 0;
+    try {
+        for (int i = 1; i + 1 < argc && !usage; i += 2) {
+            std::string arg = argv[i], value = argv[i + 1];
+            if (arg == "--grammars") {
+                grammars = value;
+            } else if (arg == "--lang") {
+                lang = value;
+            } else if (arg == "--size") {
+                size = parseSize(value);
+            } else if (arg == "--corpus") {
+                corpus = value;
+            } else if (arg == "--repeat") {
+                repeat = std::max(std::stoi(value), 1);
+            } else if (arg == "--threads") {
+                threads = std::stoul(value);
+            } else if (arg == "--comments") {
+                options.comments = std::stod(value);
+            } else if (arg == "--identifiers") {
+                options.identifiers = std::stod(value);
+            } else if (arg == "--numbers") {
+                options.numbers = std::stod(value);
+            } else if (arg == "--seed") {
+                options.seed = std::stoul(value);
+            } else if (arg == "--parser-safe") {
+                options.parserSafe = std::stoi(value) != 0;
+            } else if (arg == "--format") {
+                format = value;
+            } else if (arg == "--out") {
+                outPath = value;
+            } else {
+                usage = true;
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    usage = usage || (format != "csv" && format != "json") ||
+            (lang != "tiny" && lang != "minic" && lang != "all") ||
+            (!corpus.empty() && lang == "all");
+    if (usage) {
+        std::cerr << "usage: lexer_throughput [--grammars DIR]"
+                     " [--lang tiny|minic|all] [--size SIZE] [--corpus FILE]"
+                     " [--repeat N] [--threads N] [--comments P]"
+                     " [--identifiers W] [--numbers W] [--seed N]"
+                     " [--parser-safe 0|1] [--format csv|json] [--out FILE]"
+                  << std::endl;
+        return 1;
+    }
+
+    std::ofstream outFile;
+    if (!outPath.empty())
+        outFile.open(outPath);
+    RowWriter writer(outPath.empty() ? std::cout : outFile, format);
+    for (const char *name : {"tiny", "minic"}) {
+        if (lang != "all" && lang != name)
+            continue;
+        std::string patterns = grammars + "/" + name + ".txt";
+        try {
+            if (!corpus.empty()) {
+                MappedFile file;
+                if (!file.open(corpus)) {
+                    std::cerr << "cannot read " << corpus << std::endl;
+                    return 1;
+                }
+                measure(name, patterns, file.view(), threads, repeat, writer);
+            } else {
+                CorpusGenerator generator(Pattern("", patterns), options);
+                std::string input = generator.generate(size);
+                measure(name, patterns, input, threads, repeat, writer);
+            }
+        } catch (const std::exception &e) {
+            std::cerr << patterns << ": " << e.what() << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
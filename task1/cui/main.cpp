@@ -1,7 +1,9 @@
 #include "src/generateLexer.h"
 #include "src/lexer.h"
+#include "src/mappedFile.h"
 int main() {
-    Lexer lexer("", "../patterns.txt");
+    // automata are cached in the working directory between runs
+    Lexer lexer("", "../patterns.txt", LexerOptions{"."});
 
     Pattern &pattern = lexer.pattern;
     // pattern.printPatterns();
@@ -59,8 +61,9 @@ int main() {
     //     numDFA->acceptString(test);
     // }
 
-    // test Final DFA
+    // test Final DFA, matched on its compiled table
     DFA *finalDFA = lexer.finalDFA.get();
+    const CompiledDFA &compiledDFA = lexer.compiledDFA;
     testSuite = {"if",         "then",
                  "else",       "end",
                  "repeat",     "until",
@@ -83,9 +86,23 @@ int main() {
                  "{123",       "123}",
                  "{123",       "123}"};
     for (const auto &test : testSuite) {
-        finalDFA->acceptString(test);
+        compiledDFA.acceptString(test);
     }
     finalDFA->printStatus();
+    compiledDFA.printStatus();
     generateLexerToFile(lexer, "lexer.cpp");
+    generateLexerToFile(lexer, "tableLexer.cpp", LexerBackend::Table);
+    generateLexerToFile(lexer, "directLexer.cpp", LexerBackend::Direct);
+
+    // tokenize the input in process, straight from the mapped file; large
+    // inputs are split over all cores
+    MappedFile input("../input.txt");
+    lexer.tokenizeParallel(
+        input.view(), [&](const LexToken &token, std::string_view lexeme) {
+            std::cout << lexer.tokenToString(token, lexeme) << '\n';
+        });
+
+    // binary token stream for the parser
+    lexer.toTokenStream(input.view()).save("input.bin");
     return 0;
 }
\ No newline at end of file
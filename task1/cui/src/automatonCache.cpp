@@ -0,0 +1,219 @@
+/*
+ * File: automatonCache.cpp
+ * Project: Lexer
+ * Author: MingLLuo
+ * Usage: Save and load the DFAs of a lexer
+ */
+#include "automatonCache.h"
+#include "binaryIO.h"
+#include "mappedFile.h"
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <new>
+#include <unistd.h>
+#include <unordered_map>
+
+static const char magic[8] = {'L', 'X', 'D', 'F', 'A', '\0', '\0', '\0'};
+// smallest state: id, is_final, empty final_status, edge count
+static const size_t minStateSize = 4 + 1 + 4 + 4;
+// an edge: lo, hi, target
+static const size_t edgeSize = 1 + 1 + 4;
+
+/* patternHash: 64-bit FNV-1a of the pattern text */
+uint64_t patternHash(std::string_view text) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (char c : text) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/* automatonCachePath: cache file of a pattern text inside dir */
+std::string automatonCachePath(const std::string &dir, std::string_view text) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "lexer-%016" PRIx64 ".dfa",
+                  patternHash(text));
+    return dir + "/" + name;
+}
+
+/* putDFA: append dfa to out, states in order of id */
+static void putDFA(std::string &out, const std::string &name,
+                   const DFA &dfa) {
+    putString(out, name);
+    putValue<int32_t>(out, dfa.start_state ? dfa.start_state->id : -1);
+    std::vector<const DFAState *> states;
+    for (const auto &state : dfa.dfa_states) {
+        states.push_back(state.get());
+    }
+    std::sort(states.begin(), states.end(),
+              [](const DFAState *a, const DFAState *b) {
+                  return a->id < b->id;
+              });
+    putValue<uint32_t>(out, static_cast<uint32_t>(states.size()));
+    for (const DFAState *state : states) {
+        putValue<int32_t>(out, state->id);
+        putValue<uint8_t>(out, state->is_final);
+        putString(out, state->final_status);
+        putValue<uint32_t>(out,
+                           static_cast<uint32_t>(state->transitions.size()));
+        for (const auto &[lo, hi, target] : state->transitions) {
+            putValue(out, lo);
+            putValue(out, hi);
+            putValue<int32_t>(out, target->id);
+        }
+    }
+}
+
+/* getDFA: read a DFA written by putDFA; counts are checked against the
+ * bytes left before anything is allocated for them
+ * @return: nullptr if data is too short or refers to unknown states
+ */
+static std::shared_ptr<DFA> getDFA(std::string_view data, size_t &pos,
+                                   std::string &name) {
+    auto dfa = std::make_shared<DFA>();
+    uint32_t stateCount;
+    int32_t start;
+    if (!getString(data, pos, name) || !getValue(data, pos, start) ||
+        !getValue(data, pos, stateCount) ||
+        stateCount > (data.size() - pos) / minStateSize)
+        return nullptr;
+
+    // states first, transitions are linked once every id is known
+    std::unordered_map<int32_t, std::shared_ptr<DFAState>> byId;
+    struct Edge {
+        unsigned char lo, hi;
+        int32_t target;
+    };
+    std::vector<std::vector<Edge>> edges(stateCount);
+    std::vector<std::shared_ptr<DFAState>> states;
+    for (uint32_t i = 0; i < stateCount; i++) {
+        int32_t id;
+        uint8_t isFinal;
+        uint32_t edgeCount;
+        auto state = std::make_shared<DFAState>(0);
+        if (!getValue(data, pos, id) || !getValue(data, pos, isFinal) ||
+            !getString(data, pos, state->final_status) ||
+            !getValue(data, pos, edgeCount) ||
+            edgeCount > (data.size() - pos) / edgeSize)
+            return nullptr;
+        state->id = id;
+        state->is_final = isFinal != 0;
+        for (uint32_t j = 0; j < edgeCount; j++) {
+            Edge edge{};
+            if (!getValue(data, pos, edge.lo) ||
+                !getValue(data, pos, edge.hi) ||
+                !getValue(data, pos, edge.target) || edge.lo > edge.hi ||
+                (!edges[i].empty() && edges[i].back().hi >= edge.lo))
+                return nullptr;
+            edges[i].push_back(edge);
+        }
+        if (!byId.emplace(id, state).second)
+            return nullptr;
+        states.push_back(state);
+        dfa->dfa_states.insert(state);
+    }
+    for (uint32_t i = 0; i < stateCount; i++) {
+        for (const auto &edge : edges[i]) {
+            auto it = byId.find(edge.target);
+            if (it == byId.end())
+                return nullptr;
+            states[i]->transitions.push_back({edge.lo, edge.hi, it->second});
+        }
+    }
+    if (start != -1) {
+        auto it = byId.find(start);
+        if (it == byId.end())
+            return nullptr;
+        dfa->start_state = it->second;
+    }
+    return dfa;
+}
+
+/* saveAutomata: write the DFAs of a lexer to path; every call writes its
+ * own temporary file and renames it over path, so a reader sees one whole
+ * file even while other threads or processes save the same patterns
+ * @param text: pattern text the DFAs were built from
+ * @return: the file could be written
+ */
+bool saveAutomata(const std::string &path, std::string_view text,
+                  const DFAMap &dfas, const std::shared_ptr<DFA> &finalDFA) {
+    std::string out(magic, sizeof(magic));
+    putValue<uint32_t>(out, automatonCacheVersion);
+    putValue<uint32_t>(out, static_cast<uint32_t>(dfas.size() + 1));
+    putValue<uint64_t>(out, patternHash(text));
+    putString(out, text);
+    for (const auto &[name, dfa] : dfas) {
+        putDFA(out, name, *dfa);
+    }
+    putDFA(out, "final", *finalDFA);
+
+    // unique per call: process id and a counter shared by the threads
+    static std::atomic<uint64_t> saves{0};
+    std::string temporary = path + ".tmp" + std::to_string(getpid()) + "-" +
+                            std::to_string(saves++);
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        file.write(out.data(), static_cast<std::streamsize>(out.size()));
+        if (!file) {
+            file.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+/* loadAutomata: read the DFAs saved for text, dfas and finalDFA are only
+ * changed on success; a corrupt file that still fails to load (out of
+ * memory) is reported as not loaded, so the caller rebuilds
+ * @param text: pattern text, must equal the one the file was saved with
+ * @return: the file exists, is of this version and matches text
+ */
+bool loadAutomata(const std::string &path, std::string_view text,
+                  DFAMap &dfas, std::shared_ptr<DFA> &finalDFA) {
+    MappedFile file;
+    if (!file.open(path))
+        return false;
+    std::string_view data = file.view();
+    size_t pos = sizeof(magic);
+    uint32_t version, count;
+    uint64_t hash;
+    std::string savedText;
+    if (data.substr(0, sizeof(magic)) !=
+            std::string_view(magic, sizeof(magic)) ||
+        !getValue(data, pos, version) || version != automatonCacheVersion ||
+        !getValue(data, pos, count) || !getValue(data, pos, hash) ||
+        hash != patternHash(text) || !getString(data, pos, savedText) ||
+        savedText != text)
+        return false;
+
+    DFAMap loaded;
+    std::shared_ptr<DFA> loadedFinal;
+    try {
+        for (uint32_t i = 0; i < count; i++) {
+            std::string name;
+            auto dfa = getDFA(data, pos, name);
+            if (!dfa)
+                return false;
+            if (name == "final") {
+                loadedFinal = dfa;
+            } else {
+                loaded[name] = dfa;
+            }
+        }
+    } catch (const std::bad_alloc &) {
+        return false;
+    }
+    if (!loadedFinal || pos != data.size())
+        return false;
+    dfas = std::move(loaded);
+    finalDFA = loadedFinal;
+    return true;
+}
@@ -0,0 +1,39 @@
+/*
+ * File: automatonCache.h
+ * Project: Lexer
+ * Author: MingLLuo
+ * Usage: Save and load the DFAs of a lexer, keyed by its pattern text
+ */
+#ifndef LEXICAL_AUTOMATONCACHE_H
+#define LEXICAL_AUTOMATONCACHE_H
+
+#include "dfa.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+
+using DFAMap = std::map<std::string, std::shared_ptr<DFA>>;
+
+/* cache file, all numbers in host byte order:
+ *   header    "LXDFA\0\0\0", uint32 version, uint32 DFA count,
+ *             uint64 pattern hash, pattern text (uint32 length + bytes)
+ *   DFAs      name, start id, state count, and per state: id, final
+ *             flag, final status, transition count + (lo, hi, target id)
+ *             byte intervals in increasing order
+ * strings are a uint32 length and their bytes; the final DFA is stored
+ * under the name "final". The version also changes when the same patterns
+ * would build different automata (2: character classes, 3: intervals)
+ */
+constexpr uint32_t automatonCacheVersion = 3;
+
+uint64_t patternHash(std::string_view text);
+std::string automatonCachePath(const std::string &dir, std::string_view text);
+
+bool saveAutomata(const std::string &path, std::string_view text,
+                  const DFAMap &dfas, const std::shared_ptr<DFA> &finalDFA);
+bool loadAutomata(const std::string &path, std::string_view text,
+                  DFAMap &dfas, std::shared_ptr<DFA> &finalDFA);
+
+#endif // LEXICAL_AUTOMATONCACHE_H
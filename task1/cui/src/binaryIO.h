@@ -0,0 +1,50 @@
+/*
+ * File: binaryIO.h
+ * Project: Lexer
+ * Author: MingLLuo
+ * Usage: Helpers to write and read the binary files of the lexer
+ */
+#ifndef LEXICAL_BINARYIO_H
+#define LEXICAL_BINARYIO_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+/* putValue: append the bytes of value to out, host byte order */
+template <typename T> inline void putValue(std::string &out, T value) {
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+/* putString: append a uint32 length and the bytes of str to out */
+inline void putString(std::string &out, std::string_view str) {
+    putValue<uint32_t>(out, static_cast<uint32_t>(str.size()));
+    out.append(str);
+}
+
+/* getValue: read a T at pos of data and move pos past it
+ * @return: false if data is too short
+ */
+template <typename T>
+inline bool getValue(std::string_view data, size_t &pos, T &value) {
+    if (pos > data.size() || data.size() - pos < sizeof(T))
+        return false;
+    std::memcpy(&value, data.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+}
+
+/* getString: read a string written by putString and move pos past it
+ * @return: false if data is too short
+ */
+inline bool getString(std::string_view data, size_t &pos, std::string &str) {
+    uint32_t length;
+    if (!getValue(data, pos, length) || data.size() - pos < length)
+        return false;
+    str.assign(data.substr(pos, length));
+    pos += length;
+    return true;
+}
+
+#endif // LEXICAL_BINARYIO_H
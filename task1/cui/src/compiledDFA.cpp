@@ -0,0 +1,157 @@
+/*
+ * File: compiledDFA.cpp
+ * Project: Lexer
+ * Author: MingLLuo
+ * Usage: Define the CompiledDFA class
+ */
+#include "compiledDFA.h"
+
+/* CompiledDFA: flatten dfa, states are numbered in BFS order from start,
+ * then the 256 columns are merged into byte equivalence classes
+ * @param dfa: DFA to compile
+ */
+CompiledDFA::CompiledDFA(const DFA &dfa) {
+    if (dfa.start_state == nullptr)
+        return;
+
+    // token kinds, sorted by name so the numbering is stable
+    std::set<std::string> names;
+    for (const auto &state : dfa.dfa_states) {
+        if (state->is_final)
+            names.insert(state->final_status);
+    }
+    kinds.assign(names.begin(), names.end());
+    std::map<std::string, int32_t> kindIndex;
+    for (int32_t i = 0; i < static_cast<int32_t>(kinds.size()); i++) {
+        kindIndex[kinds[i]] = i;
+    }
+
+    std::unordered_map<const DFAState *, int32_t> index;
+    std::vector<const DFAState *> order;
+    index[dfa.start_state.get()] = 0;
+    order.push_back(dfa.start_state.get());
+    for (size_t i = 0; i < order.size(); i++) {
+        for (const auto &transition : order[i]->transitions) {
+            const DFAState *target = transition.target.get();
+            if (target != nullptr && index.find(target) == index.end()) {
+                index[target] = static_cast<int32_t>(order.size());
+                order.push_back(target);
+            }
+        }
+    }
+
+    start = 0;
+    stateCount = static_cast<int32_t>(order.size());
+    classCount = alphabet;
+    for (int c = 0; c < alphabet; c++) {
+        classMap[c] = static_cast<uint8_t>(c);
+    }
+    next.assign(static_cast<size_t>(stateCount) * alphabet, DEAD);
+    accept.assign(stateCount, NO_KIND);
+    for (int32_t s = 0; s < stateCount; s++) {
+        const DFAState *state = order[s];
+        if (state->is_final)
+            accept[s] = kindIndex[state->final_status];
+        for (const auto &[lo, hi, target] : state->transitions) {
+            if (target == nullptr)
+                continue;
+            for (int c = lo; c <= hi; c++) {
+                next[static_cast<size_t>(s) * alphabet + c] =
+                    index[target.get()];
+            }
+        }
+    }
+    compressAlphabet();
+}
+
+/* compressAlphabet: merge bytes whose columns are equal in every state
+ * the full table (classMap is the identity) is rewritten with one column
+ * per class, classes are numbered by their smallest byte
+ */
+void CompiledDFA::compressAlphabet() {
+    std::map<std::vector<int32_t>, int32_t> columnClass;
+    std::vector<int32_t> representative;
+    std::vector<int32_t> column(stateCount);
+    for (int c = 0; c < alphabet; c++) {
+        for (int32_t s = 0; s < stateCount; s++) {
+            column[s] = next[static_cast<size_t>(s) * alphabet + c];
+        }
+        auto it = columnClass.find(column);
+        if (it == columnClass.end()) {
+            it = columnClass
+                     .emplace(column,
+                              static_cast<int32_t>(representative.size()))
+                     .first;
+            representative.push_back(c);
+        }
+        classMap[c] = static_cast<uint8_t>(it->second);
+    }
+
+    classCount = static_cast<int32_t>(representative.size());
+    std::vector<int32_t> compressed(static_cast<size_t>(stateCount) *
+                                    classCount);
+    for (int32_t s = 0; s < stateCount; s++) {
+        for (int32_t k = 0; k < classCount; k++) {
+            compressed[static_cast<size_t>(s) * classCount + k] =
+                next[static_cast<size_t>(s) * alphabet + representative[k]];
+        }
+    }
+    next = std::move(compressed);
+}
+
+/* match: run the whole string through the table
+ * @return: token kind, or NO_KIND if str is not accepted
+ */
+int32_t CompiledDFA::match(std::string_view str) const {
+    if (empty())
+        return NO_KIND;
+    int32_t state = start;
+    for (const char c : str) {
+        state = step(state, static_cast<unsigned char>(c));
+        if (state == DEAD)
+            return NO_KIND;
+    }
+    return accept[state];
+}
+
+/* longestMatch: longest accepted prefix of str
+ * @param kind: set to the token kind of the prefix, NO_KIND if none
+ * @return: length of the prefix, 0 if none
+ */
+size_t CompiledDFA::longestMatch(std::string_view str, int32_t &kind) const {
+    kind = NO_KIND;
+    if (empty())
+        return 0;
+    size_t length = 0;
+    int32_t state = start;
+    for (size_t i = 0; i < str.size(); i++) {
+        state = step(state, static_cast<unsigned char>(str[i]));
+        if (state == DEAD)
+            break;
+        if (accept[state] != NO_KIND) {
+            kind = accept[state];
+            length = i + 1;
+        }
+    }
+    return length;
+}
+
+/* acceptString: check if the string is accepted, same output as DFA */
+void CompiledDFA::acceptString(const std::string &str) const {
+    int32_t kind = match(str);
+    if (kind != NO_KIND) {
+        std::cout << "String " << str << " is accepted as " << kinds[kind]
+                  << std::endl;
+    } else {
+        std::cout << "String " << str << " is not accepted\n";
+    }
+}
+
+/* printStatus: print the size of the tables */
+void CompiledDFA::printStatus() const {
+    std::cout << "count of compiled states: " << stateCount << "\n";
+    std::cout << "count of token kinds: " << kinds.size() << "\n";
+    std::cout << "count of byte classes: " << classCount << "\n";
+    std::cout << "size of transition table: " << next.size() * sizeof(int32_t)
+              << " bytes\n";
+}
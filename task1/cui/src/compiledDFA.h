@@ -0,0 +1,54 @@
+/*
+ * File: compiledDFA.h
+ * Project: Lexer
+ * Author: MingLLuo
+ * Usage: Define the CompiledDFA class, a flat table form of a DFA
+ */
+#ifndef LEXICAL_COMPILEDDFA_H
+#define LEXICAL_COMPILEDDFA_H
+
+#include "dfa.h"
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+/* CompiledDFA: DFA with dense state ids and one contiguous transition table
+ * bytes that every state treats the same way share an equivalence class,
+ * next[state * classCount + classMap[byte]] is the next state or DEAD,
+ * accept[state] is the index of the token kind in kinds, or NO_KIND
+ */
+class CompiledDFA {
+  public:
+    static constexpr int32_t DEAD = -1;
+    static constexpr int32_t NO_KIND = -1;
+    static constexpr int alphabet = 256;
+
+    int32_t start = DEAD;
+    int32_t stateCount = 0;
+    int32_t classCount = 0;
+    std::array<uint8_t, alphabet> classMap{};
+    std::vector<int32_t> next;
+    std::vector<int32_t> accept;
+    std::vector<std::string> kinds;
+
+    CompiledDFA() = default;
+
+    explicit CompiledDFA(const DFA &dfa);
+
+    [[nodiscard]] bool empty() const { return start == DEAD; }
+
+    [[nodiscard]] int32_t step(int32_t state, unsigned char c) const {
+        return next[static_cast<size_t>(state) * classCount + classMap[c]];
+    }
+
+    [[nodiscard]] int32_t match(std::string_view str) const;
+    size_t longestMatch(std::string_view str, int32_t &kind) const;
+
+    void acceptString(const std::string &str) const;
+    void printStatus() const;
+
+  private:
+    void compressAlphabet();
+};
+
+#endif // LEXICAL_COMPILEDDFA_H
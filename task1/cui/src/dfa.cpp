@@ -6,9 +6,35 @@
  */
 #include "dfa.h"
 
-/* DFAState: constructor */
-DFAState::DFAState(std::set<std::shared_ptr<NFAState>> nfa_states)
-    : nfa_states(std::move(nfa_states)), id(fresh()), is_final(false) {}
+/* DFAState: constructor
+ * @param id: state id
+ * @param nfa_states: sorted indices of the NFA states it stands for
+ */
+DFAState::DFAState(int id, std::vector<uint32_t> nfa_states)
+    : id(id), nfa_states(std::move(nfa_states)), is_final(false) {}
+
+/* addTransition: add [lo, hi] -> target after every transition so far,
+ * merged into the last one when it is adjacent with the same target
+ */
+void DFAState::addTransition(unsigned char lo, unsigned char hi,
+                             std::shared_ptr<DFAState> target) {
+    if (!transitions.empty() && transitions.back().hi + 1 == lo &&
+        transitions.back().target == target) {
+        transitions.back().hi = hi;
+        return;
+    }
+    transitions.push_back({lo, hi, std::move(target)});
+}
+
+/* next: target on byte c, nullptr if there is none */
+DFAState *DFAState::next(unsigned char c) const {
+    auto it = std::upper_bound(
+        transitions.begin(), transitions.end(), c,
+        [](unsigned char byte, const DFATransition &t) { return byte < t.lo; });
+    if (it == transitions.begin() || (--it)->hi < c)
+        return nullptr;
+    return it->target.get();
+}
 
 /* DFAState: print the state */
 void DFAState::printDFAState() const {
@@ -20,7 +46,7 @@ void DFAState::printDFAState() const {
         if (!first)
             std::cout << ", ";
         first = false;
-        std::cout << nfaState->id;
+        std::cout << nfaState;
     }
     std::cout << "}\n";
 }
@@ -28,157 +54,185 @@ void DFAState::printDFAState() const {
 /* DFAState: print the transitions */
 void DFAState::printTransitions() const {
     for (const auto &transition : transitions) {
-        std::cout << "  Input " << transition.first << " ";
-        if (transition.second != nullptr)
-            transition.second->printDFAState();
+        std::cout << "  Input " << transition.lo;
+        if (transition.hi != transition.lo)
+            std::cout << "-" << transition.hi;
+        std::cout << " ";
+        if (transition.target != nullptr)
+            transition.target->printDFAState();
         else
             std::cout << "nullptr\n";
     }
 }
 
-std::set<std::shared_ptr<NFAState>>
-epsilonClosure(const std::set<std::shared_ptr<NFAState>> &states) {
-    std::set<std::shared_ptr<NFAState>> closure = states;
-    std::stack<std::shared_ptr<NFAState>> stack;
+/* StateSet: sorted NFA state indices with a precomputed hash */
+struct StateSet {
+    std::vector<uint32_t> states;
+    size_t hash = 0;
 
-    for (const auto &state : states) {
-        if (state != nullptr)
-            stack.push(state);
+    explicit StateSet(std::vector<uint32_t> sorted) : states(std::move(sorted)) {
+        hash = states.size();
+        for (uint32_t state : states) {
+            hash ^= state + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+        }
     }
 
-    while (!stack.empty()) {
-        auto current = stack.top();
-        stack.pop();
-
-        // Find epsilon transitions
-        const auto &transitions = current->transitions.find(0);
-        if (transitions != current->transitions.end()) {
-            for (const auto &nextState : transitions->second) {
-                if (nextState != nullptr &&
-                    closure.find(nextState) == closure.end()) {
-                    closure.insert(nextState);
-                    stack.push(nextState);
-                }
-            }
-            closure.insert(current);
-        }
+    bool operator==(const StateSet &other) const {
+        return hash == other.hash && states == other.states;
     }
+};
 
-    return closure;
-}
+struct StateSetHash {
+    size_t operator()(const StateSet &set) const { return set.hash; }
+};
 
-/* move: move the states with input symbol */
-std::set<std::shared_ptr<NFAState>>
-move(const std::set<std::shared_ptr<NFAState>> &states, char inputSymbol) {
-    std::set<std::shared_ptr<NFAState>> result;
-
-    for (const auto &state : states) {
-        const auto &transitions = state->transitions.find(inputSymbol);
-        if (transitions != state->transitions.end()) {
-            for (const auto &nextState : transitions->second) {
-                if (nextState != nullptr)
-                    result.insert(nextState);
+/* SubsetBuilder: edge lists of the NFA arena and the scratch buffers
+ * shared by every closure / move of one subset construction
+ */
+class SubsetBuilder {
+  public:
+    explicit SubsetBuilder(const NFA &nfa) : closures(nfa) {
+        edges.resize(nfa.states.size());
+        for (uint32_t i = 0; i < nfa.states.size(); i++) {
+            for (const NFAEdge &edge : nfa.states[i].transitions) {
+                if (!edge.isEpsilon())
+                    edges[i].push_back(edge);
             }
         }
+        mark.assign((nfa.states.size() + 63) / 64, 0);
     }
 
-    return result;
-}
-
-/* createDFAState: create a new DFA state */
-std::shared_ptr<DFAState>
-createDFAState(const std::set<std::shared_ptr<NFAState>> &nfaStates) {
-    return std::make_shared<DFAState>(nfaStates);
-}
-
-/* convertToDFA: convert NFA to DFA */
-std::shared_ptr<DFA> convertToDFA(const std::shared_ptr<NFA> &nfa) {
-    flush();
-    // Subset Construction Algorithm
-    auto dfa = std::make_shared<DFA>();
-    std::map<std::set<std::shared_ptr<NFAState>>, std::shared_ptr<DFAState>>
-        dfaStateMap;
-
-    auto initialState = epsilonClosure({nfa->start_state});
-    dfa->start_state = createDFAState(initialState);
-    dfaStateMap[initialState] = dfa->start_state;
-
-    std::stack<std::shared_ptr<DFAState>> stack;
-    stack.push(dfa->start_state);
-
-    while (!stack.empty()) {
-        auto dfaState = stack.top();
-        stack.pop();
-
-        // set final state for new state
-        bool isFinalState = false;
-        std::string finalStatus;
-        for (const auto &nfaState : dfaState->nfa_states) {
-            if (nfaState->is_final) {
-                isFinalState = true;
-                if (finalStatus.empty())
-                    finalStatus = nfaState->final_status;
-                // keyword, symbol, num, id
-                if (nfaState->final_status != "id")
-                    finalStatus = nfaState->final_status;
+    /* closure: union of the precomputed closures of seeds, sorted, seeds
+     * are consumed
+     */
+    std::vector<uint32_t> closure(std::vector<uint32_t> &seeds) {
+        std::vector<uint32_t> result;
+        for (uint32_t seed : seeds) {
+            if (testAndSet(seed))
+                continue; // its closure is already in result
+            for (auto it = closures.begin(seed); it != closures.end(seed);
+                 ++it) {
+                if (*it == seed || !testAndSet(*it))
+                    result.push_back(*it);
             }
         }
-        dfaState->is_final = isFinalState;
-        dfaState->final_status = finalStatus;
-
-        for (auto inputSymbol : nfa->symbols) {
-            std::set<std::shared_ptr<NFAState>> nfaTransitions =
-                move(dfaState->nfa_states, inputSymbol);
-            std::set<std::shared_ptr<NFAState>> epsilonTransitions =
-                epsilonClosure(nfaTransitions);
-
-            // no nfaTransitions
-            if (epsilonTransitions.empty())
-                continue;
+        for (uint32_t state : result) {
+            mark[state >> 6] &= ~(1ULL << (state & 63));
+        }
+        seeds.clear();
+        std::sort(result.begin(), result.end());
+        return result;
+    }
 
-            if (dfaStateMap.find(epsilonTransitions) == dfaStateMap.end()) {
-                auto newState = createDFAState(epsilonTransitions);
-                dfaStateMap[epsilonTransitions] = newState;
-                stack.push(newState);
+    /* moveAll: cut the bytes at every edge end of set, so each segment
+     * [bounds[j], bounds[j + 1]) is moved on as a whole; buckets[j] gets
+     * the targets of segment j, it stays empty if no edge covers it
+     */
+    void moveAll(const std::vector<uint32_t> &set) {
+        bounds.clear();
+        for (uint32_t state : set) {
+            for (const NFAEdge &edge : edges[state]) {
+                bounds.push_back(edge.lo);
+                bounds.push_back(edge.hi + 1);
             }
-            if (inputSymbol == '\0') {
-                continue;
+        }
+        std::sort(bounds.begin(), bounds.end());
+        bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+        segments = bounds.empty() ? 0 : bounds.size() - 1;
+        if (buckets.size() < segments)
+            buckets.resize(segments);
+        for (uint32_t state : set) {
+            for (const NFAEdge &edge : edges[state]) {
+                auto first = std::lower_bound(bounds.begin(), bounds.end(),
+                                              static_cast<int>(edge.lo));
+                auto last = std::lower_bound(first, bounds.end(),
+                                             edge.hi + 1);
+                for (auto j = first - bounds.begin();
+                     j < last - bounds.begin(); j++) {
+                    buckets[j].push_back(edge.to);
+                }
             }
-            dfaState->transitions[inputSymbol] =
-                dfaStateMap[epsilonTransitions];
         }
+    }
 
-        for (const auto &it : dfaStateMap) {
-            dfa->dfa_states.insert(it.second);
-        }
+    EpsilonClosure closures;
+    std::vector<std::vector<NFAEdge>> edges;
+    std::vector<int> bounds;
+    size_t segments = 0;
+    std::vector<std::vector<uint32_t>> buckets;
+
+  private:
+    bool testAndSet(uint32_t state) {
+        uint64_t bit = 1ULL << (state & 63);
+        bool was = mark[state >> 6] & bit;
+        mark[state >> 6] |= bit;
+        return was;
     }
-    dfa->symbols = nfa->symbols;
-    dfa->symbols.erase(0);
 
-    // unpoint clean, use bfs
-    // create new transistion map
-    flush();
-    std::set<std::shared_ptr<DFAState>> visited;
-    std::stack<std::shared_ptr<DFAState>> stack2;
-    std::map<std::shared_ptr<DFAState>, int> newIdMap;
-    stack2.push(dfa->start_state);
-    visited.insert(dfa->start_state);
-    while (!stack2.empty()) {
-        auto currentState = stack2.top();
-        stack2.pop();
-        newIdMap[currentState] = fresh();
-        currentState->id = newIdMap[currentState];
-        for (const auto &transition : currentState->transitions) {
-            if (visited.find(transition.second) == visited.end()) {
-                visited.insert(transition.second);
-                stack2.push(transition.second);
-            }
-        }
+    std::vector<uint64_t> mark;
+};
+
+/* resolveFinalStatus: token of a set of NFA states, any status other than
+ * "id" wins over "id", otherwise the state with the smallest index wins
+ * @param nfa: NFA the states belong to
+ * @param set: sorted NFA state indices
+ * @param finalStatus: set to the status of the token, if any
+ * @return: some state of set is final
+ */
+bool resolveFinalStatus(const NFA &nfa, const std::vector<uint32_t> &set,
+                        std::string &finalStatus) {
+    bool isFinal = false;
+    for (uint32_t state : set) {
+        const NFAState *nfaState = &nfa.states[state];
+        if (!nfaState->is_final)
+            continue;
+        // keyword, symbol, num, id
+        if (!isFinal || (finalStatus == "id" && nfaState->final_status != "id"))
+            finalStatus = nfaState->final_status;
+        isFinal = true;
     }
-    dfa->dfa_states = visited;
-    for (auto &state : dfa->dfa_states) {
-        for (auto &transition : state->transitions) {
-            transition.second->id = newIdMap[transition.second];
+    return isFinal;
+}
+
+/* convertToDFA: convert NFA to DFA by subset construction, DFA states are
+ * numbered in BFS order from 1
+ */
+std::shared_ptr<DFA> convertToDFA(const std::shared_ptr<NFA> &nfa) {
+    auto dfa = std::make_shared<DFA>();
+    if (nfa->empty())
+        return dfa;
+
+    SubsetBuilder builder(*nfa);
+    std::unordered_map<StateSet, std::shared_ptr<DFAState>, StateSetHash>
+        dfaStateMap;
+    std::vector<std::shared_ptr<DFAState>> queue;
+
+    auto lookup = [&](std::vector<uint32_t> set) {
+        StateSet key(std::move(set));
+        auto it = dfaStateMap.find(key);
+        if (it != dfaStateMap.end())
+            return it->second;
+        auto state = std::make_shared<DFAState>(
+            static_cast<int>(queue.size()) + 1, key.states);
+        state->is_final =
+            resolveFinalStatus(*nfa, state->nfa_states, state->final_status);
+        dfaStateMap.emplace(std::move(key), state);
+        dfa->dfa_states.insert(state);
+        queue.push_back(state);
+        return state;
+    };
+
+    std::vector<uint32_t> seeds{nfa->start_state};
+    dfa->start_state = lookup(builder.closure(seeds));
+    for (size_t i = 0; i < queue.size(); i++) {
+        auto dfaState = queue[i];
+        builder.moveAll(dfaState->nfa_states);
+        for (size_t j = 0; j < builder.segments; j++) {
+            if (builder.buckets[j].empty())
+                continue;
+            auto target = lookup(builder.closure(builder.buckets[j]));
+            dfaState->addTransition(builder.bounds[j],
+                                    builder.bounds[j + 1] - 1, target);
         }
     }
     return dfa;
@@ -204,9 +258,9 @@ void DFA::printDFA() const {
         currentState->printTransitions();
 
         for (const auto &transition : currentState->transitions) {
-            if (visited.find(transition.second) == visited.end()) {
-                visited.insert(transition.second);
-                stack.push(transition.second);
+            if (visited.find(transition.target) == visited.end()) {
+                visited.insert(transition.target);
+                stack.push(transition.target);
             }
         }
     }
@@ -214,17 +268,10 @@ void DFA::printDFA() const {
 
 /* acceptString: check if the string is accepted by the DFA */
 void DFA::acceptString(const std::string &str) const {
-    std::shared_ptr<DFAState> currentState = start_state;
+    const DFAState *currentState = start_state.get();
     for (const auto symbol : str) {
-        bool found = false;
-        for (const auto &transition : currentState->transitions) {
-            if (transition.first == symbol) {
-                currentState = transition.second;
-                found = true;
-                break;
-            }
-        }
-        if (!found) {
+        currentState = currentState->next(static_cast<unsigned char>(symbol));
+        if (currentState == nullptr) {
             std::cout << "String " << str << " is not accepted\n";
             return;
         }
@@ -247,120 +294,229 @@ void DFA::setFinalStatus(const std::string &str) const {
 /* printStatus: print the status of the DFA */
 void DFA::printStatus() const {
     std::cout << "count of DFA states: " << dfa_states.size() << "\n";
+    std::set<unsigned char> symbols;
+    for (const auto &state : dfa_states) {
+        for (const auto &transition : state->transitions) {
+            for (int c = transition.lo; c <= transition.hi; c++) {
+                symbols.insert(static_cast<unsigned char>(c));
+            }
+        }
+    }
     std::cout << "count of symbols: " << symbols.size() << "\n";
 }
 
-/* minimizeDFA: minimize the DFA */
-std::shared_ptr<DFA> DFA::minimizeDFA() {
-    std::unordered_map<std::shared_ptr<DFAState>, int> state_to_partition;
-    std::unordered_map<int, std::unordered_set<std::shared_ptr<DFAState>>>
-        partition_map;
-    state_to_partition[nullptr] = -1;
-    // count the different final status
-    int current_partition = 1;
-    std::unordered_map<std::string, int> final_status_map;
-    for (const auto &state : this->dfa_states) {
-        if (state->is_final) {
-            if (final_status_map.find(state->final_status) ==
-                final_status_map.end()) {
-                final_status_map[state->final_status] = current_partition;
-                current_partition++;
+/* minimizeDFA: minimize the DFA, final states with different final_status
+ * are never merged, see minimizeDFAWithMulStatus
+ */
+std::shared_ptr<DFA> DFA::minimizeDFA() const {
+    return minimizeDFAWithMulStatus();
+}
+
+/* minimizeDFAWithMulStatus: Hopcroft minimization of the (partial) DFA
+ * missing transitions go to an implicit dead state, the initial partition
+ * groups states by final_status, blocks are refined with a splitter
+ * worklist, always queueing the smaller half; this DFA is left untouched
+ */
+std::shared_ptr<DFA> DFA::minimizeDFAWithMulStatus() const {
+    auto new_dfa = std::make_shared<DFA>();
+    if (start_state == nullptr)
+        return new_dfa;
+
+    // dense index of the reachable states, dead state is n
+    std::unordered_map<const DFAState *, int> index;
+    std::vector<const DFAState *> states;
+    index[start_state.get()] = 0;
+    states.push_back(start_state.get());
+    for (size_t i = 0; i < states.size(); i++) {
+        for (const auto &transition : states[i]->transitions) {
+            const DFAState *target = transition.target.get();
+            if (target != nullptr && index.find(target) == index.end()) {
+                index[target] = static_cast<int>(states.size());
+                states.push_back(target);
             }
-            state_to_partition[state] = final_status_map[state->final_status];
-            partition_map[state_to_partition[state]].insert(state);
-        } else {
-            state_to_partition[state] = 0;
-            partition_map[state_to_partition[state]].insert(state);
         }
     }
-    bool changed = true;
-    while (changed) {
-        changed = false;
-
-        for (auto &[partition, states] : partition_map) {
-            if (states.size() <= 1) {
+    const int n = static_cast<int>(states.size());
+    const int dead = n;
+    const int total = n + 1;
+
+    // the alphabet: bytes are cut at both ends of every transition, so the
+    // bytes of segment a, [bounds[a], bounds[a + 1]), act alike everywhere
+    std::vector<int> bounds;
+    for (const DFAState *state : states) {
+        for (const auto &transition : state->transitions) {
+            bounds.push_back(transition.lo);
+            bounds.push_back(transition.hi + 1);
+        }
+    }
+    std::sort(bounds.begin(), bounds.end());
+    bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+    const int k = bounds.empty() ? 0 : static_cast<int>(bounds.size()) - 1;
+
+    // delta[s * k + a], then its inverse in CSR form keyed by (target, a)
+    std::vector<int> delta(static_cast<size_t>(total) * k, dead);
+    for (int s = 0; s < n; s++) {
+        for (const auto &[lo, hi, target] : states[s]->transitions) {
+            if (target == nullptr)
                 continue;
+            auto first = std::lower_bound(bounds.begin(), bounds.end(),
+                                          static_cast<int>(lo));
+            auto last = std::lower_bound(first, bounds.end(), hi + 1);
+            for (auto a = first - bounds.begin(); a < last - bounds.begin();
+                 a++) {
+                delta[static_cast<size_t>(s) * k + a] = index[target.get()];
             }
-            for (auto inputSymbol : this->symbols) {
-                std::unordered_map<
-                    int, std::unordered_set<std::shared_ptr<DFAState>>>
-                    temp_partition_map;
-                for (const auto &state : states) {
-                    auto next_state = state->transitions[inputSymbol];
-                    // maybe nullptr, but it's ok~
-                    temp_partition_map[state_to_partition[next_state]].insert(
-                        state);
-                }
-                // if size == 1, we won't change the partition
-                // tmp_map size is 1: point to themselves or other same
-                // partition
-                if (temp_partition_map.size() > 1) {
-                    // next state of them are not in the same partition
-                    // remove the old partition, and add new partition
-                    changed = true;
-                    partition_map.erase(partition);
-                    for (const auto &[new_partition, new_states] :
-                         temp_partition_map) {
-                        for (const auto &new_state : new_states) {
-                            state_to_partition[new_state] = current_partition;
-                        }
-                        partition_map[current_partition] = new_states;
-                        current_partition++;
-                    }
-                    break;
-                }
-            }
-            if (changed)
-                break;
         }
     }
+    std::vector<int> invStart(static_cast<size_t>(total) * k + 1, 0);
+    for (size_t i = 0; i < delta.size(); i++) {
+        invStart[static_cast<size_t>(delta[i]) * k + i % k + 1]++;
+    }
+    for (size_t i = 1; i < invStart.size(); i++) {
+        invStart[i] += invStart[i - 1];
+    }
+    std::vector<int> invFill(invStart.begin(), invStart.end() - 1);
+    std::vector<int> inverse(delta.size());
+    for (size_t i = 0; i < delta.size(); i++) {
+        inverse[invFill[static_cast<size_t>(delta[i]) * k + i % k]++] =
+            static_cast<int>(i / k);
+    }
 
-    // Create new DFA
-    auto new_dfa = std::make_shared<DFA>();
-    std::map<std::shared_ptr<DFAState>, std::shared_ptr<DFAState>>
-        new_state_map;
-    new_dfa->symbols = this->symbols;
-    // Create new states
-    flush();
-    for (const auto &[partition, states] : partition_map) {
-        int id = fresh();
-        // // Debug
-        // std::cout << "Partition " << partition << " {\n";
-        // for (const auto &state : states) {
-        //     std::cout << "  DFAState Id: " << state->id << std::endl
-        //               << "  Is Final: " << state->is_final << std::endl;
-        //     if (state->is_final)
-        //         std::cout << "  Final Status: " << state->final_status
-        //                   << std::endl;
-        //     state->printDFAState();
-        //     //            state->printTransitions();
-        // }
-        // std::cout << "}\n" << id << std::endl;
-        auto new_state = std::make_shared<DFAState>(id);
-        for (const auto &state : states) {
-            new_state_map[state] = new_state;
-            if (state == this->start_state)
-                new_dfa->start_state = new_state;
-            if (state->is_final) {
-                new_state->is_final = true;
-                new_state->final_status = state->final_status;
-            }
+    // partition: elems is grouped by block, marked states sit at the front
+    std::vector<int> elems(total), position(total), blockOf(total);
+    std::vector<int> blockStart, blockEnd, marked;
+    std::map<std::pair<bool, std::string>, int> initialBlocks;
+    std::vector<std::vector<int>> initialMembers;
+    for (int s = 0; s < total; s++) {
+        std::pair<bool, std::string> key{false, ""};
+        if (s != dead && states[s]->is_final)
+            key = {true, states[s]->final_status};
+        auto it = initialBlocks.find(key);
+        if (it == initialBlocks.end()) {
+            it = initialBlocks
+                     .emplace(key, static_cast<int>(initialMembers.size()))
+                     .first;
+            initialMembers.emplace_back();
+        }
+        initialMembers[it->second].push_back(s);
+    }
+    int cursor = 0;
+    for (int b = 0; b < static_cast<int>(initialMembers.size()); b++) {
+        blockStart.push_back(cursor);
+        for (int s : initialMembers[b]) {
+            elems[cursor] = s;
+            position[s] = cursor++;
+            blockOf[s] = b;
         }
-        new_dfa->dfa_states.insert(new_state);
+        blockEnd.push_back(cursor);
+        marked.push_back(0);
+    }
+
+    // queue every initial block except the largest one
+    std::vector<char> inWorklist(blockStart.size(), 1);
+    int largest = 0;
+    for (int b = 1; b < static_cast<int>(blockStart.size()); b++) {
+        if (blockEnd[b] - blockStart[b] >
+            blockEnd[largest] - blockStart[largest])
+            largest = b;
+    }
+    inWorklist[largest] = 0;
+    std::vector<int> worklist;
+    for (int b = 0; b < static_cast<int>(blockStart.size()); b++) {
+        if (inWorklist[b])
+            worklist.push_back(b);
     }
 
-    // after partition, we can create new transitions
-    for (const auto &[partition, states] : partition_map) {
-        // Create transitions
-        for (const auto &state : states) {
-            for (const auto &[inputSymbol, nextState] : state->transitions) {
-                if (nextState == nullptr || inputSymbol == '\0') {
+    std::vector<int> splitter, touched;
+    while (!worklist.empty()) {
+        int block = worklist.back();
+        worklist.pop_back();
+        inWorklist[block] = 0;
+        splitter.assign(elems.begin() + blockStart[block],
+                        elems.begin() + blockEnd[block]);
+
+        for (int a = 0; a < k; a++) {
+            // mark all predecessors of the splitter on symbol a
+            for (int q : splitter) {
+                size_t key = static_cast<size_t>(q) * k + a;
+                for (int i = invStart[key]; i < invStart[key + 1]; i++) {
+                    int p = inverse[i];
+                    int b = blockOf[p];
+                    int target = blockStart[b] + marked[b];
+                    if (position[p] < target)
+                        continue; // already marked
+                    if (marked[b] == 0)
+                        touched.push_back(b);
+                    int other = elems[target];
+                    std::swap(elems[position[p]], elems[target]);
+                    position[other] = position[p];
+                    position[p] = target;
+                    marked[b]++;
+                }
+            }
+
+            // split every touched block into marked / unmarked halves
+            for (int b : touched) {
+                int count = marked[b];
+                marked[b] = 0;
+                if (count == blockEnd[b] - blockStart[b])
                     continue;
+                int newBlock = static_cast<int>(blockStart.size());
+                blockStart.push_back(blockStart[b]);
+                blockEnd.push_back(blockStart[b] + count);
+                marked.push_back(0);
+                blockStart[b] += count;
+                for (int i = blockStart[newBlock]; i < blockEnd[newBlock];
+                     i++) {
+                    blockOf[elems[i]] = newBlock;
+                }
+                int smaller = newBlock;
+                if (blockEnd[b] - blockStart[b] < count)
+                    smaller = b;
+                inWorklist.push_back(0);
+                int queued = inWorklist[b] ? newBlock : smaller;
+                if (!inWorklist[queued]) {
+                    inWorklist[queued] = 1;
+                    worklist.push_back(queued);
                 }
-                new_state_map[state]->transitions[inputSymbol] =
-                    new_state_map[nextState];
             }
+            touched.clear();
+        }
+    }
+
+    // one new state per block, numbered in BFS order, dead block dropped
+    int deadBlock = blockOf[dead];
+    std::vector<std::shared_ptr<DFAState>> blockState(blockStart.size());
+    auto stateOf = [&](int b) {
+        if (blockState[b] == nullptr) {
+            const DFAState *member = states[elems[blockStart[b]]];
+            blockState[b] = std::make_shared<DFAState>(
+                static_cast<int>(new_dfa->dfa_states.size()) + 1);
+            blockState[b]->is_final = member->is_final;
+            blockState[b]->final_status = member->final_status;
+            new_dfa->dfa_states.insert(blockState[b]);
+        }
+        return blockState[b];
+    };
+    new_dfa->start_state = std::make_shared<DFAState>(1);
+    if (blockOf[0] == deadBlock) {
+        new_dfa->dfa_states.insert(new_dfa->start_state);
+        return new_dfa;
+    }
+    new_dfa->start_state = stateOf(blockOf[0]);
+    std::vector<int> queue{blockOf[0]};
+    for (size_t i = 0; i < queue.size(); i++) {
+        int b = queue[i];
+        int member = elems[blockStart[b]];
+        for (int a = 0; a < k; a++) {
+            int target = blockOf[delta[static_cast<size_t>(member) * k + a]];
+            if (target == deadBlock)
+                continue;
+            if (blockState[target] == nullptr)
+                queue.push_back(target);
+            blockState[b]->addTransition(bounds[a], bounds[a + 1] - 1,
+                                         stateOf(target));
         }
     }
     return new_dfa;
-}
\ No newline at end of file
+}
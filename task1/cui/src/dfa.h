@@ -8,6 +8,8 @@
 #define LEXICAL_DFA_H
 
 #include "nfa.h"
+#include <algorithm>
+#include <cstdint>
 #include <map>
 #include <queue>
 #include <stack>
@@ -15,17 +17,32 @@
 #include <utility>
 #include <vector>
 
+class DFAState;
+
+/* DFATransition: any byte of [lo, hi] leads to target */
+struct DFATransition {
+    unsigned char lo;
+    unsigned char hi;
+    std::shared_ptr<DFAState> target;
+};
+
 class DFAState {
   public:
+    // number of the state inside its DFA, given by the builder of the DFA
     int id;
-    std::set<std::shared_ptr<NFAState>> nfa_states;
-    std::map<char, std::shared_ptr<DFAState>> transitions;
+    std::vector<uint32_t> nfa_states;
+    // sorted by lo and disjoint, adjacent intervals have different targets
+    std::vector<DFATransition> transitions;
     bool is_final;
     std::string final_status;
 
-    DFAState(std::set<std::shared_ptr<NFAState>> nfa_states);
+    DFAState(int id, std::vector<uint32_t> nfa_states);
+
+    DFAState(int id) : id(id), is_final(false) {}
 
-    DFAState(int id) : id(id) {}
+    void addTransition(unsigned char lo, unsigned char hi,
+                       std::shared_ptr<DFAState> target);
+    [[nodiscard]] DFAState *next(unsigned char c) const;
 
     void printDFAState() const;
 
@@ -36,12 +53,11 @@ class DFA {
   public:
     std::shared_ptr<DFAState> start_state;
     std::set<std::shared_ptr<DFAState>> dfa_states;
-    std::set<char> symbols;
 
     void printDFA() const;
 
-    std::shared_ptr<DFA> minimizeDFA();
-    std::shared_ptr<DFA> minimizeDFAWithMulStatus();
+    [[nodiscard]] std::shared_ptr<DFA> minimizeDFA() const;
+    [[nodiscard]] std::shared_ptr<DFA> minimizeDFAWithMulStatus() const;
 
     void acceptString(const std::string &str) const;
     void setFinalStatus(const std::string &str) const;
@@ -49,5 +65,7 @@ class DFA {
 };
 
 std::shared_ptr<DFA> convertToDFA(const std::shared_ptr<NFA> &nfa);
+bool resolveFinalStatus(const NFA &nfa, const std::vector<uint32_t> &set,
+                        std::string &finalStatus);
 
 #endif // LEXICAL_DFA_H
\ No newline at end of file
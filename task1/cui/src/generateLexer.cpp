@@ -5,6 +5,7 @@
  * Usage: Define the generateLexer function
  */
 #include "generateLexer.h"
+#include "embeddedSources.h"
 
 /* charToOut: convert char to string
  * @param c: char to convert
@@ -27,24 +28,166 @@ std::string charToOut(char c) {
     return "\\\'";
   } else if (c == '\f') {
     return "\\f";
+  } else if (static_cast<unsigned char>(c) < 0x20 ||
+             static_cast<unsigned char>(c) >= 0x7f) {
+    const char *hex = "0123456789abcdef";
+    return std::string("\\x") + hex[static_cast<unsigned char>(c) >> 4] +
+           hex[c & 15];
   } else {
     return std::string(1, c);
   }
 }
 
-/* generateLexer: generate lexer code
+/* stringToOut: convert string to a C++ string literal; control and non
+ * ASCII bytes are 3-digit octal escapes, a \x escape would take the hex
+ * digits after it
+ * @param s: string to convert
+ * @return: quoted string
+ */
+static std::string stringToOut(const std::string &s) {
+  std::string result = "\"";
+  for (char c : s) {
+    auto byte = static_cast<unsigned char>(c);
+    std::string out = charToOut(c);
+    if (out.compare(0, 2, "\\x") == 0) {
+      out = {'\\', static_cast<char>('0' + (byte >> 6)),
+             static_cast<char>('0' + ((byte >> 3) & 7)),
+             static_cast<char>('0' + (byte & 7))};
+    }
+    result += out;
+  }
+  return result + "\"";
+}
+
+/* emitArray: emit a static const array, 16 values per line
+ * @param code: output stream
+ * @param type: element type
+ * @param name: array name
+ * @param values: elements
+ */
+template <typename T>
+static void emitArray(std::ostringstream &code, const std::string &type,
+                      const std::string &name, const std::vector<T> &values) {
+  code << "static const " << type << " " << name << "[" << values.size()
+       << "] = {";
+  for (size_t i = 0; i < values.size(); i++) {
+    if (i % 16 == 0) {
+      code << "\n   ";
+    }
+    code << " " << static_cast<long long>(values[i]) << ",";
+  }
+  code << "\n};\n\n";
+}
+
+/* emitKeywordHash: the perfect hash of lexer.keywordHash and findKeyword,
+ * which gives the slot of a keyword or -1; nothing without keyword hash
+ */
+static void emitKeywordHash(std::ostringstream &code, const Lexer &lexer) {
+  const KeywordHash &hash = lexer.keywordHash;
+  if (hash.empty()) {
+    return;
+  }
+  code << "static const uint32_t keywordDisplace[" << hash.displace.size()
+       << "] = {";
+  for (size_t i = 0; i < hash.displace.size(); i++) {
+    code << (i % 12 == 0 ? "\n    " : " ") << hash.displace[i] << ",";
+  }
+  code << "\n};\n";
+  code << "static const char *const keywordKeys[" << hash.keys.size()
+       << "] = {\n";
+  for (const auto &key : hash.keys) {
+    code << "    " << stringToOut(key) << ",\n";
+  }
+  code << "};\n";
+  code << "static const int keywordKinds[" << hash.kinds.size() << "] = {";
+  for (size_t i = 0; i < hash.kinds.size(); i++) {
+    code << (i % 12 == 0 ? "\n    " : " ") << hash.kinds[i] << ",";
+  }
+  code << "\n};\n\n";
+  emitArray(code, "bool", "reclassify",
+            std::vector<int>(lexer.reclassify.begin(), lexer.reclassify.end()));
+  code << "// same as KeywordHash::hash\n";
+  code << "static uint64_t keywordHash(uint64_t seed, const char *p, size_t n) "
+          "{\n";
+  code << "    uint64_t h = 0xcbf29ce484222325ULL ^ (seed * "
+          "0x9e3779b97f4a7c15ULL);\n";
+  code << "    for (size_t i = 0; i < n; i++) {\n";
+  code << "        h ^= static_cast<unsigned char>(p[i]);\n";
+  code << "        h *= 0x100000001b3ULL;\n";
+  code << "    }\n";
+  code << "    h ^= h >> 33;\n";
+  code << "    h *= 0xff51afd7ed558ccdULL;\n";
+  code << "    h ^= h >> 33;\n";
+  code << "    h *= 0xc4ceb9fe1a85ec53ULL;\n";
+  code << "    h ^= h >> 33;\n";
+  code << "    return h;\n";
+  code << "}\n\n";
+  code << "static int findKeyword(const char *p, size_t n) {\n";
+  code << "    uint64_t bucket = keywordHash(0, p, n) % "
+       << hash.displace.size() << ";\n";
+  code << "    size_t slot = keywordHash(keywordDisplace[bucket], p, n) % "
+       << hash.keys.size() << ";\n";
+  code << "    const char *key = keywordKeys[slot];\n";
+  code << "    return std::strlen(key) == n && std::memcmp(key, p, n) == 0\n";
+  code << "               ? static_cast<int>(slot)\n";
+  code << "               : -1;\n";
+  code << "}\n\n";
+}
+
+/* readInputSource: generated helper, maps a regular file and read()s
+ * anything else, same strategy as MappedFile
+ */
+static const char *const readInputSource = R"(
+static const char *readInput(const char *path, size_t &size,
+                             std::string &fallback) {
+    size = 0;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return "";
+    struct stat st {};
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                       MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+            close(fd);
+            size = static_cast<size_t>(st.st_size);
+            return static_cast<const char *>(p);
+        }
+    }
+    char block[1 << 16];
+    ssize_t n;
+    while ((n = read(fd, block, sizeof(block))) > 0) {
+        fallback.append(block, static_cast<size_t>(n));
+    }
+    close(fd);
+    size = fallback.size();
+    return fallback.data();
+}
+)";
+
+/* generateMapLexer: generate lexer code with one std::map per state
  * @param lexer: lexer object
  * @return: generated code
  */
-std::string generateLexer(const Lexer &lexer) {
+static std::string generateMapLexer(const Lexer &lexer) {
   std::shared_ptr<DFA> dfa = lexer.finalDFA;
   std::ostringstream code;
 
+  code << "#include <algorithm>\n";
   code << "#include <iostream>\n";
   code << "#include <string>\n";
   code << "#include <map>\n";
   code << "#include <fstream>\n";
-  code << "#include <functional>\n\n";
+  code << "#include <functional>\n";
+  code << "#include <cstdint>\n";
+  code << "#include <cstring>\n";
+  code << "#include <fcntl.h>\n";
+  code << "#include <sys/mman.h>\n";
+  code << "#include <sys/stat.h>\n";
+  code << "#include <unistd.h>\n";
+  code << scanSkipSource << readInputSource << "\n";
+  emitKeywordHash(code, lexer);
 
   code << "bool isspace(char c) {\n";
   code << "    return c == ' ' || c == '\\t' || c == '\\n' || c == '\\r';\n";
@@ -59,9 +202,9 @@ std::string generateLexer(const Lexer &lexer) {
     code << "void state" << state->id
          << "(char inputSymbol, int& currentState) {\n";
     std::map<char, int> transitions;
-    for (const auto &transition : state->transitions) {
-      if (transition.first != 0 && transition.second != nullptr) {
-        transitions[transition.first] = transition.second->id;
+    for (const auto &[lo, hi, target] : state->transitions) {
+      for (int c = lo; target != nullptr && c <= hi; c++) {
+        transitions[static_cast<char>(c)] = target->id;
       }
     }
     code << "    std::map<char, int> transitions = {\n";
@@ -117,6 +260,16 @@ std::string generateLexer(const Lexer &lexer) {
       }
     }
     code << ") {\n";
+    auto kind = std::find(lexer.compiledDFA.kinds.begin(),
+                          lexer.compiledDFA.kinds.end(), finalState.first);
+    if (!lexer.keywordHash.empty() && kind != lexer.compiledDFA.kinds.end() &&
+        lexer.reclassify[kind - lexer.compiledDFA.kinds.begin()]) {
+      // a keyword left out of the DFA
+      code << "        if (findKeyword(input.data(), input.size()) >= 0) {\n";
+      code << "            std::cout << \"Token: \" << input;\n";
+      code << "            return 1;\n";
+      code << "        }\n";
+    }
     code << "        std::cout << \"Token: " << finalState.first << "\";\n";
     if (finalState.first == "num" || finalState.first == "id") {
       code << "    return 2;\n";
@@ -138,27 +291,56 @@ std::string generateLexer(const Lexer &lexer) {
   code << "}\n\n";
 
   code << "int main() {\n";
-  code << "    std::ifstream file(\"../input.txt\");\n";
-  code << "    std::string input, total;\n";
-  code << "    while (std::getline(file, input)) {\n";
-  code << "        total += input + \"\\n\";\n";
-  code << "    }\n";
-  code << "    file.close();\n";
+  code << "    std::string fallback;\n";
+  code << "    size_t size;\n";
+  code << "    const char *data = readInput(\"../input.txt\", size, "
+          "fallback);\n";
+  code << "    std::string_view total(data, size);\n";
   code << "    std::vector<std::string> tokens;\n";
   code << "    std::string token;\n";
   code << "    bool insideComment = false;\n";
-  code << "    for (int i = 0; i < total.size(); i++) {\n";
+  code << "    const char *end = total.data() + total.size();\n";
+  code << "    for (size_t i = 0; i < total.size(); i++) {\n";
+  // a whitespace run outside a token is dropped whole
+  code << "       if (token.empty() && isspace(total[i])) {\n";
+  code << "           i = skipWhitespace(total.data() + i, end) - "
+          "total.data() - 1;\n";
+  code << "           continue;\n";
+  code << "       }\n";
   if (lexer.pattern.comment == "") {
-    code << "       if (total.substr(i, " << lexer.pattern.lcomment.size()
-         << ") == \"" << lexer.pattern.lcomment << "\") {\n";
+    const std::string &lcomment = lexer.pattern.lcomment;
+    const std::string &rcomment = lexer.pattern.rcomment;
+    if (!lcomment.empty() && !rcomment.empty()) {
+      // a comment body is appended up to the next delimiter at once
+      code << "       if (insideComment && total.compare(i, "
+           << lcomment.size() << ", " << stringToOut(lcomment)
+           << ") != 0 && total.compare(i, " << rcomment.size() << ", "
+           << stringToOut(rcomment) << ") != 0) {\n";
+      code << "           const char *open = findDelimiter(total.data() + i, "
+              "end, "
+           << stringToOut(lcomment) << ");\n";
+      code << "           const char *close = findDelimiter(total.data() + "
+              "i, end, "
+           << stringToOut(rcomment) << ");\n";
+      code << "           const char *stop = open == nullptr ? close : "
+              "close == nullptr ? open : std::min(open, close);\n";
+      code << "           stop = stop == nullptr ? end : stop;\n";
+      code << "           token.append(total.data() + i, stop - total.data() "
+              "- i);\n";
+      code << "           i = stop - total.data() - 1;\n";
+      code << "           continue;\n";
+      code << "       }\n";
+    }
+    code << "       if (total.compare(i, " << lexer.pattern.lcomment.size()
+         << ", \"" << lexer.pattern.lcomment << "\") == 0) {\n";
     code << "           insideComment = true;\n";
     code << "           token += total.substr(i, "
          << lexer.pattern.lcomment.size() << ");\n";
     code << "           i += " << lexer.pattern.lcomment.size() - 1 << ";\n";
     code << "           continue;\n";
     code << "       }\n";
-    code << "       if (total.substr(i, " << lexer.pattern.rcomment.size()
-         << ") == \"" << lexer.pattern.rcomment << "\") {\n";
+    code << "       if (total.compare(i, " << lexer.pattern.rcomment.size()
+         << ", \"" << lexer.pattern.rcomment << "\") == 0) {\n";
     code << "           insideComment = false;\n";
     code << "           token += total.substr(i, "
          << lexer.pattern.rcomment.size() << ");\n";
@@ -205,12 +387,13 @@ std::string generateLexer(const Lexer &lexer) {
     code << "           token += c;\n";
     code << "       }\n";
   } else {
-    code << "       if (total.substr(i, " << lexer.pattern.comment.size()
-         << ") == \"" << lexer.pattern.comment << "\") {\n";
-    code << "           while (i < total.size() && total[i] != '\\n') {\n";
-    code << "               token += total[i];\n";
-    code << "               i++;\n";
-    code << "           }\n";
+    code << "       if (total.compare(i, " << lexer.pattern.comment.size()
+         << ", \"" << lexer.pattern.comment << "\") == 0) {\n";
+    code << "           const char *lineEnd = findLineEnd(total.data() + i, "
+            "end);\n";
+    code << "           token.append(total.data() + i, lineEnd - total.data() "
+            "- i);\n";
+    code << "           i = lineEnd - total.data();\n";
     code << "           tokens.push_back(token);\n";
     code << "           token.clear();\n";
     code << "           continue;\n";
@@ -279,11 +462,344 @@ std::string generateLexer(const Lexer &lexer) {
   return code.str();
 }
 
+/* emitPrologue: includes, scan helpers and the token kind names shared by the
+ * table and direct backends
+ * @param code: output stream
+ * @param dfa: compiled DFA of the lexer
+ */
+static void emitPrologue(std::ostringstream &code, const CompiledDFA &dfa) {
+  code << "#include <algorithm>\n";
+  code << "#include <cstdint>\n";
+  code << "#include <cstring>\n";
+  code << "#include <fcntl.h>\n";
+  code << "#include <fstream>\n";
+  code << "#include <iostream>\n";
+  code << "#include <string>\n";
+  code << "#include <vector>\n";
+  code << "#include <sys/mman.h>\n";
+  code << "#include <sys/stat.h>\n";
+  code << "#include <unistd.h>\n";
+  code << "#include <unordered_map>\n";
+  code << scanSkipSource << "\n";
+
+  code << "static const char *const kinds[" << dfa.kinds.size() << "] = {\n";
+  std::vector<int> hasValue;
+  for (const auto &kind : dfa.kinds) {
+    code << "    " << stringToOut(kind) << ",\n";
+    hasValue.push_back(kind == "id" || kind == "num");
+  }
+  code << "};\n\n";
+  emitArray(code, "bool", "hasValue", hasValue);
+}
+
+/* tokenStreamSource: generated writer of the binary token stream, through
+ * writeTokenStream of tokenStreamWriter.h; lexemes are interned by views
+ * into the mapped input, which stays alive until the stream is written
+ */
+static const char *const tokenStreamSource = R"(
+struct Symbols {
+    std::unordered_map<std::string_view, uint32_t> ids;
+    std::string pool;
+    std::vector<uint32_t> offsets{0};
+
+    uint32_t intern(std::string_view text) {
+        auto [it, added] = ids.emplace(text, offsets.size() - 1);
+        if (added) {
+            pool.append(text);
+            offsets.push_back(static_cast<uint32_t>(pool.size()));
+        }
+        return it->second;
+    }
+};
+
+static bool writeTokens(const char *path,
+                        const std::vector<TokenRecord> &records,
+                        const Symbols &symbols) {
+    std::vector<std::string_view> names(std::begin(kinds), std::end(kinds));
+    std::ofstream file(path, std::ios::binary);
+    writeTokenStream(
+        [&](const char *p, size_t n) {
+            file.write(p, static_cast<std::streamsize>(n));
+        },
+        names, records, symbols.offsets, symbols.pool);
+    return static_cast<bool>(file);
+}
+)";
+
+/* emitReadInput: start of main, maps ../input.txt as data / size; with a
+ * path argument the tokens are collected for the binary stream instead of
+ * printed
+ */
+static void emitReadInput(std::ostringstream &code) {
+  code << readInputSource << binaryIOSource << tokenStreamWriterSource
+       << tokenStreamSource << "\n";
+  code << "int main(int argc, char **argv) {\n";
+  code << "    std::string fallback;\n";
+  code << "    size_t size;\n";
+  code << "    const char *data = readInput(\"../input.txt\", size, "
+          "fallback);\n";
+  code << "    const char *binaryPath = argc > 1 ? argv[1] : nullptr;\n";
+  code << "    std::vector<TokenRecord> records;\n";
+  code << "    Symbols symbols;\n";
+  code << "    uint32_t line = 1;\n";
+  code << "    size_t counted = 0;\n";
+  code << "    std::string out;\n";
+  code << "    size_t pos = 0;\n";
+}
+
+/* emitTokenOutput: the token found at pos (kind, length) is printed or
+ * recorded, a single space is skipped, an invalid byte is reported; then
+ * pos moves past it. The text output is flushed in 64 KB pieces
+ */
+static void emitTokenOutput(std::ostringstream &code, const Lexer &lexer) {
+  if (!lexer.keywordHash.empty()) {
+    code << "        if (length > 0 && reclassify[kind]) {\n";
+    code << "            int slot = findKeyword(data + pos, length);\n";
+    code << "            if (slot >= 0)\n";
+    code << "                kind = keywordKinds[slot];\n";
+    code << "        }\n";
+  }
+  code << "        if (length == 0 && isSpaceByte(data[pos])) {\n";
+  code << "            pos++;\n";
+  code << "            continue;\n";
+  code << "        }\n";
+  code << "        if (length == 0) {\n";
+  code << "            kind = -1;\n";
+  code << "            length = 1;\n";
+  code << "        }\n";
+  code << "        if (binaryPath != nullptr) {\n";
+  code << "            line += std::count(data + counted, data + pos, "
+          "'\\n');\n";
+  code << "            counted = pos;\n";
+  code << "            uint32_t symbol = symbols.intern({data + pos, "
+          "length});\n";
+  code << "            records.push_back({symbols.offsets[symbol], "
+          "static_cast<uint32_t>(kind),\n";
+  code << "                               static_cast<uint32_t>(length), "
+          "line, symbol});\n";
+  code << "        } else if (kind >= 0) {\n";
+  code << "            out += \"Token: \";\n";
+  code << "            out += kinds[kind];\n";
+  code << "            if (hasValue[kind]) {\n";
+  code << "                out += \" -> \";\n";
+  code << "                out.append(data + pos, length);\n";
+  code << "            }\n";
+  code << "            out += '\\n';\n";
+  code << "        } else {\n";
+  code << "            out += \"Invalid token: \";\n";
+  code << "            out += data[pos];\n";
+  code << "            out += '\\n';\n";
+  code << "        }\n";
+  code << "        pos += length;\n";
+  code << "        if (out.size() >= (1 << 16)) {\n";
+  code << "            std::cout << out;\n";
+  code << "            out.clear();\n";
+  code << "        }\n";
+}
+
+/* emitEpilogue: end of main, writes the binary stream or the rest of the
+ * text output
+ */
+static void emitEpilogue(std::ostringstream &code) {
+  code << "    if (binaryPath != nullptr)\n";
+  code << "        return writeTokens(binaryPath, records, symbols) ? 0 "
+          ": 1;\n";
+  code << "    std::cout << out;\n";
+  code << "    return 0;\n";
+  code << "}\n";
+}
+
+/* emitFastPaths: open the body of the scan loop, whitespace runs and
+ * comment bodies are skipped with the scan helpers; leaves an open else
+ * block for the DFA, closed by emitTokenOutput
+ * @param code: output stream
+ * @param lexer: lexer object
+ */
+static void emitFastPaths(std::ostringstream &code, const Lexer &lexer) {
+  const Pattern &pattern = lexer.pattern;
+  if (lexer.skipSpaces) {
+    code << "        if (isSpaceByte(data[pos])) {\n";
+    code << "            pos = skipWhitespace(data + pos, data + size) - "
+            "data;\n";
+    code << "            continue;\n";
+    code << "        }\n";
+  }
+  code << "        int kind = -1;\n";
+  code << "        size_t length = 0;\n";
+  code << "        const char *close = nullptr;\n";
+  if (lexer.commentKind != LexToken::ERROR_KIND) {
+    if (!pattern.comment.empty()) {
+      size_t n = pattern.comment.size();
+      code << "        if (size - pos >= " << n << " && std::memcmp(data + pos, "
+           << stringToOut(pattern.comment) << ", " << n << ") == 0) {\n";
+      code << "            close = findLineEnd(data + pos + " << n
+           << ", data + size);\n";
+      code << "        }\n";
+    } else if (!pattern.lcomment.empty()) {
+      size_t n = pattern.lcomment.size();
+      code << "        if (size - pos >= " << n << " && std::memcmp(data + pos, "
+           << stringToOut(pattern.lcomment) << ", " << n << ") == 0) {\n";
+      code << "            close = findDelimiter(data + pos + " << n
+           << ", data + size, " << stringToOut(pattern.rcomment) << ");\n";
+      code << "            if (close != nullptr)\n";
+      code << "                close += " << pattern.rcomment.size() << ";\n";
+      code << "        }\n";
+    }
+  }
+  code << "        if (close != nullptr) {\n";
+  code << "            kind = " << lexer.commentKind << ";\n";
+  code << "            length = close - (data + pos);\n";
+  code << "        } else {\n";
+}
+
+/* generateTableLexer: generate a table driven lexer from compiledDFA, the
+ * scanner is the maximal munch loop of Lexer::tokenize
+ * @param lexer: lexer object
+ * @return: generated code
+ */
+static std::string generateTableLexer(const Lexer &lexer) {
+  const CompiledDFA &dfa = lexer.compiledDFA;
+  std::ostringstream code;
+
+  emitPrologue(code, dfa);
+  emitKeywordHash(code, lexer);
+  // the narrowest type that holds every state and DEAD
+  std::string stateType = dfa.stateCount < INT16_MAX ? "int16_t" : "int32_t";
+  code << "static const int START = " << dfa.start << ";\n";
+  code << "static const int CLASS_COUNT = " << dfa.classCount << ";\n\n";
+  emitArray(code, "uint8_t", "classMap",
+            std::vector<uint8_t>(dfa.classMap.begin(), dfa.classMap.end()));
+  emitArray(code, stateType, "next", dfa.next);
+  emitArray(code, stateType, "accept", dfa.accept);
+
+  emitReadInput(code);
+  code << "    while (pos < size) {\n";
+  emitFastPaths(code, lexer);
+  code << "        int state = START;\n";
+  code << "        size_t i = pos;\n";
+  code << "        while (i < size) {\n";
+  code << "            state = next[state * CLASS_COUNT + "
+          "classMap[(unsigned char)data[i++]]];\n";
+  code << "            if (state < 0)\n";
+  code << "                break;\n";
+  code << "            if (accept[state] >= 0) {\n";
+  code << "                kind = accept[state];\n";
+  code << "                length = i - pos;\n";
+  code << "            }\n";
+  code << "        }\n";
+  code << "        }\n";
+  emitTokenOutput(code, lexer);
+  code << "    }\n";
+  emitEpilogue(code);
+
+  return code.str();
+}
+
+/* caseLabel: case label for one input byte
+ * @param c: input byte
+ * @return: "case 'c':", or the number for bytes that are not printable
+ */
+static std::string caseLabel(int c) {
+  if (c >= 0x20 && c < 0x7f) {
+    return "case '" + charToOut(static_cast<char>(c)) + "':";
+  }
+  return "case " + std::to_string(c) + ":";
+}
+
+/* generateDirectLexer: generate a direct coded lexer from compiledDFA,
+ * every state is a label with a switch on the next byte, states jump to
+ * each other with goto
+ * @param lexer: lexer object
+ * @return: generated code
+ */
+static std::string generateDirectLexer(const Lexer &lexer) {
+  const CompiledDFA &dfa = lexer.compiledDFA;
+  std::ostringstream code;
+
+  emitPrologue(code, dfa);
+  emitKeywordHash(code, lexer);
+  emitReadInput(code);
+  code << "    while (pos < size) {\n";
+  emitFastPaths(code, lexer);
+  code << "        size_t i = pos;\n";
+  code << "        goto s" << dfa.start << ";\n";
+  for (int32_t state = 0; state < dfa.stateCount; state++) {
+    code << "    s" << state << ":\n";
+    if (dfa.accept[state] != CompiledDFA::NO_KIND) {
+      code << "        kind = " << dfa.accept[state] << ";\n";
+      code << "        length = i - pos;\n";
+    }
+    // group the bytes by target state, in order of their first byte
+    std::vector<int32_t> targets;
+    std::map<int32_t, std::vector<int>> bytes;
+    for (int c = 0; c < CompiledDFA::alphabet; c++) {
+      int32_t target = dfa.step(state, static_cast<unsigned char>(c));
+      if (target == CompiledDFA::DEAD)
+        continue;
+      if (bytes.find(target) == bytes.end())
+        targets.push_back(target);
+      bytes[target].push_back(c);
+    }
+    if (targets.empty()) {
+      code << "        goto done;\n";
+      continue;
+    }
+    code << "        if (i == size)\n";
+    code << "            goto done;\n";
+    code << "        switch ((unsigned char)data[i++]) {\n";
+    for (int32_t target : targets) {
+      code << "       ";
+      int column = 0;
+      for (int c : bytes[target]) {
+        if (column++ == 8) {
+          code << "\n       ";
+          column = 1;
+        }
+        code << " " << caseLabel(c);
+      }
+      code << "\n            goto s" << target << ";\n";
+    }
+    code << "        default:\n";
+    code << "            goto done;\n";
+    code << "        }\n";
+  }
+  code << "    done:;\n";
+  code << "        }\n";
+  emitTokenOutput(code, lexer);
+  code << "    }\n";
+  emitEpilogue(code);
+
+  return code.str();
+}
+
+/* generateLexer: generate lexer code
+ * @param lexer: lexer object
+ * @param backend: shape of the generated scanner
+ * @return: generated code, empty for a lazy lexer, which has no DFA
+ */
+std::string generateLexer(const Lexer &lexer, LexerBackend backend) {
+  if (lexer.finalDFA == nullptr) {
+    std::cerr << "Error: The lexer has no DFA to generate from" << std::endl;
+    return "";
+  }
+  switch (backend) {
+  case LexerBackend::Table:
+    return generateTableLexer(lexer);
+  case LexerBackend::Direct:
+    return generateDirectLexer(lexer);
+  case LexerBackend::Map:
+  default:
+    return generateMapLexer(lexer);
+  }
+}
+
 /* generateLexerToFile: generate lexer code and write to file
  * @param lexer: lexer object
  * @param filename: output file name
+ * @param backend: shape of the generated scanner
  */
-void generateLexerToFile(const Lexer &lexer, const std::string &filename) {
+void generateLexerToFile(const Lexer &lexer, const std::string &filename,
+                         LexerBackend backend) {
   std::ofstream file(filename);
 
   if (!file.is_open()) {
@@ -292,6 +808,6 @@ void generateLexerToFile(const Lexer &lexer, const std::string &filename) {
     return;
   }
 
-  file << generateLexer(lexer);
+  file << generateLexer(lexer, backend);
   file.close();
 }
@@ -7,10 +7,22 @@
 #ifndef GENERATELEXER_H
 #define GENERATELEXER_H
 #include "lexer.h"
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+
+/* LexerBackend: shape of the generated scanner
+ * Map: one function and one std::map per state
+ * Table: static transition / accept tables and a tight loop
+ * Direct: one label per state with a switch on the byte, states are
+ * linked with goto
+ */
+enum class LexerBackend { Map, Table, Direct };
+
 std::string charToOut(char c);
-std::string generateLexer(const Lexer &lexer);
-void generateLexerToFile(const Lexer &lexer, const std::string &filename);
+std::string generateLexer(const Lexer &lexer,
+                          LexerBackend backend = LexerBackend::Map);
+void generateLexerToFile(const Lexer &lexer, const std::string &filename,
+                         LexerBackend backend = LexerBackend::Map);
 #endif
\ No newline at end of file
@@ -0,0 +1,64 @@
+/*
+ * File: keywordHash.cpp
+ * Project: Lexer
+ * Author: MingLLuo
+ * Usage: Define the KeywordHash class
+ */
+#include "keywordHash.h"
+#include <algorithm>
+#include <numeric>
+
+/* KeywordHash: constructor, buckets are placed largest first, each with
+ * the first seed that moves all of its keywords to free slots
+ * @param keywords: distinct keywords and their token kinds
+ */
+KeywordHash::KeywordHash(
+    const std::vector<std::pair<std::string, int32_t>> &keywords) {
+    if (keywords.empty())
+        return;
+    size_t size = keywords.size();
+    // about four keywords per bucket
+    size_t bucketCount = (size + 3) / 4;
+    std::vector<std::vector<size_t>> buckets(bucketCount);
+    for (size_t i = 0; i < size; i++) {
+        buckets[hash(0, keywords[i].first) % bucketCount].push_back(i);
+    }
+    std::vector<size_t> order(bucketCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return buckets[a].size() > buckets[b].size();
+    });
+
+    displace.assign(bucketCount, 0);
+    keys.assign(size, "");
+    kinds.assign(size, NONE);
+    std::vector<char> used(size, 0);
+    std::vector<size_t> slots;
+    for (size_t bucket : order) {
+        if (buckets[bucket].empty())
+            break;
+        for (uint32_t seed = 1;; seed++) {
+            slots.clear();
+            bool placed = true;
+            for (size_t i : buckets[bucket]) {
+                size_t slot = hash(seed, keywords[i].first) % size;
+                if (used[slot] || std::find(slots.begin(), slots.end(),
+                                            slot) != slots.end()) {
+                    placed = false;
+                    break;
+                }
+                slots.push_back(slot);
+            }
+            if (!placed)
+                continue;
+            displace[bucket] = seed;
+            for (size_t j = 0; j < slots.size(); j++) {
+                size_t i = buckets[bucket][j];
+                used[slots[j]] = 1;
+                keys[slots[j]] = keywords[i].first;
+                kinds[slots[j]] = keywords[i].second;
+            }
+            break;
+        }
+    }
+}
@@ -0,0 +1,68 @@
+/*
+ * File: keywordHash.h
+ * Project: Lexer
+ * Author: MingLLuo
+ * Usage: Define the KeywordHash class, minimal perfect hash of keywords
+ */
+#ifndef LEXICAL_KEYWORDHASH_H
+#define LEXICAL_KEYWORDHASH_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/* KeywordHash: minimal perfect hash of a fixed keyword set, built by hash
+ * and displace: a keyword falls in bucket hash(0, word) % buckets, and every
+ * bucket has a seed so that hash(seed, word) % size sends the keywords of
+ * all buckets to distinct slots; a lookup costs two hashes and one compare
+ */
+class KeywordHash {
+  public:
+    static constexpr int32_t NONE = -1;
+
+    // seed of every bucket, keyword and kind of every slot
+    std::vector<uint32_t> displace;
+    std::vector<std::string> keys;
+    std::vector<int32_t> kinds;
+
+    KeywordHash() = default;
+
+    explicit KeywordHash(
+        const std::vector<std::pair<std::string, int32_t>> &keywords);
+
+    [[nodiscard]] bool empty() const { return keys.empty(); }
+
+    /* find: kind of word, or NONE if word is not a keyword */
+    [[nodiscard]] int32_t find(std::string_view word) const {
+        if (keys.empty())
+            return NONE;
+        size_t slot = slotOf(word);
+        return keys[slot] == word ? kinds[slot] : NONE;
+    }
+
+    [[nodiscard]] size_t slotOf(std::string_view word) const {
+        uint64_t bucket = hash(0, word) % displace.size();
+        return hash(displace[bucket], word) % keys.size();
+    }
+
+    /* hash: FNV-1a of word from a seeded basis, then the murmur3 finalizer
+     * so that nearby seeds give unrelated values
+     */
+    static uint64_t hash(uint64_t seed, std::string_view word) {
+        uint64_t h = 0xcbf29ce484222325ULL ^ (seed * 0x9e3779b97f4a7c15ULL);
+        for (char c : word) {
+            h ^= static_cast<unsigned char>(c);
+            h *= 0x100000001b3ULL;
+        }
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+};
+
+#endif // LEXICAL_KEYWORDHASH_H
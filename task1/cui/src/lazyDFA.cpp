@@ -0,0 +1,199 @@
+/*
+ * File: lazyDFA.cpp
+ * Project: Lexer
+ * Author: MingLLuo
+ * Usage: Define the LazyDFA class
+ */
+#include "lazyDFA.h"
+
+/* LazyDFA: prepare the NFA side of the construction; bytes that label the
+ * same NFA edges share a class, the kinds are the statuses of final states
+ * @param nfa: NFA to scan with, kept alive by the LazyDFA
+ * @param maxStates: capacity of every Cache, at least 2 (start and one more)
+ */
+LazyDFA::LazyDFA(std::shared_ptr<NFA> nfa, size_t maxStates)
+    : nfa(std::move(nfa)), closures(*this->nfa),
+      limit(std::max<size_t>(maxStates, 2)) {
+    const auto &states = this->nfa->states;
+
+    // byte classes: the list of edges a byte is in is its signature
+    std::vector<std::vector<uint32_t>> signature(alphabet);
+    uint32_t edgeCount = 0;
+    for (const auto &state : states) {
+        for (const auto &edge : state.transitions) {
+            for (int c = edge.lo; !edge.isEpsilon() && c <= edge.hi; c++) {
+                signature[c].push_back(edgeCount);
+            }
+            edgeCount++;
+        }
+    }
+    std::map<std::vector<uint32_t>, uint8_t> classOf;
+    for (int c = 0; c < alphabet; c++) {
+        auto it = classOf.emplace(signature[c], classOf.size()).first;
+        classMap[c] = it->second;
+    }
+    classCount = static_cast<int32_t>(classOf.size());
+
+    // an edge covers whole classes, it is listed once for each of them
+    edges.resize(states.size());
+    std::vector<char> seen(classCount);
+    for (uint32_t i = 0; i < states.size(); i++) {
+        for (const auto &edge : states[i].transitions) {
+            if (edge.isEpsilon())
+                continue;
+            std::fill(seen.begin(), seen.end(), 0);
+            for (int c = edge.lo; c <= edge.hi; c++) {
+                if (!seen[classMap[c]]) {
+                    seen[classMap[c]] = 1;
+                    edges[i].emplace_back(classMap[c], edge.to);
+                }
+            }
+        }
+    }
+
+    std::set<std::string> names;
+    for (const auto &state : states) {
+        if (state.is_final)
+            names.insert(state.final_status);
+    }
+    kinds.assign(names.begin(), names.end());
+    for (int32_t i = 0; i < static_cast<int32_t>(kinds.size()); i++) {
+        kindIndex[kinds[i]] = i;
+    }
+
+    if (!this->nfa->empty()) {
+        startSet.assign(closures.begin(this->nfa->start_state),
+                        closures.end(this->nfa->start_state));
+        std::sort(startSet.begin(), startSet.end());
+    }
+}
+
+/* acquire: a cache for one thread, a released one if there is any so the
+ * states built by earlier scans are reused
+ */
+std::unique_ptr<LazyDFA::Cache> LazyDFA::acquire() const {
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (!pool.empty()) {
+            auto cache = std::move(pool.back());
+            pool.pop_back();
+            return cache;
+        }
+    }
+    return std::make_unique<Cache>(*this);
+}
+
+/* release: give back a cache taken with acquire */
+void LazyDFA::release(std::unique_ptr<Cache> cache) const {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    pool.push_back(std::move(cache));
+}
+
+/* Cache: empty cache holding only the start state
+ * @param dfa: LazyDFA the states are built for
+ */
+LazyDFA::Cache::Cache(const LazyDFA &dfa)
+    : dfa(dfa), mark((dfa.nfa->states.size() + 63) / 64, 0) {
+    flush();
+}
+
+/* SetHash: hash of a sorted set of NFA states */
+size_t LazyDFA::Cache::SetHash::operator()(
+    const std::vector<uint32_t> &set) const {
+    size_t hash = set.size();
+    for (uint32_t state : set) {
+        hash ^= state + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    }
+    return hash;
+}
+
+/* match: kind of the token str is as a whole, or NO_KIND */
+int32_t LazyDFA::Cache::match(std::string_view str) {
+    int32_t state = start;
+    for (char c : str) {
+        state = step(state, static_cast<unsigned char>(c));
+        if (state == DEAD)
+            return NO_KIND;
+    }
+    return accept[state];
+}
+
+/* build: take the transition of state on cls for the first time; when the
+ * cache is full it is flushed first and the transition is not recorded,
+ * since state no longer exists
+ * @return: target state or DEAD
+ */
+int32_t LazyDFA::Cache::build(int32_t state, uint8_t cls) {
+    for (uint32_t member : sets[state]) {
+        for (const auto &[edgeClass, target] : dfa.edges[member]) {
+            if (edgeClass == cls)
+                seeds.push_back(target);
+        }
+    }
+    std::vector<uint32_t> set = closure();
+    size_t slot = static_cast<size_t>(state) * dfa.classCount + cls;
+    if (set.empty()) {
+        next[slot] = DEAD;
+        return DEAD;
+    }
+    auto it = index.find(set);
+    if (it != index.end()) {
+        next[slot] = it->second;
+        return it->second;
+    }
+    if (sets.size() >= dfa.limit) {
+        flush();
+        flushes++;
+        return addState(std::move(set));
+    }
+    int32_t target = addState(std::move(set));
+    next[slot] = target;
+    return target;
+}
+
+/* addState: add a state for a set not in the cache yet
+ * @return: the new state
+ */
+int32_t LazyDFA::Cache::addState(std::vector<uint32_t> set) {
+    auto state = static_cast<int32_t>(sets.size());
+    std::string status;
+    accept.push_back(resolveFinalStatus(*dfa.nfa, set, status)
+                         ? dfa.kindIndex.at(status)
+                         : NO_KIND);
+    next.resize(next.size() + dfa.classCount, UNKNOWN);
+    index.emplace(set, state);
+    sets.push_back(std::move(set));
+    return state;
+}
+
+/* flush: forget every state, then add the start state again as state 0 */
+void LazyDFA::Cache::flush() {
+    sets.clear();
+    index.clear();
+    accept.clear();
+    next.clear();
+    addState(dfa.startSet);
+}
+
+/* closure: union of the precomputed closures of seeds, sorted, seeds are
+ * consumed
+ */
+std::vector<uint32_t> LazyDFA::Cache::closure() {
+    std::vector<uint32_t> result;
+    for (uint32_t seed : seeds) {
+        for (auto it = dfa.closures.begin(seed); it != dfa.closures.end(seed);
+             ++it) {
+            uint64_t bit = 1ULL << (*it & 63);
+            if (!(mark[*it >> 6] & bit)) {
+                mark[*it >> 6] |= bit;
+                result.push_back(*it);
+            }
+        }
+    }
+    for (uint32_t state : result) {
+        mark[state >> 6] &= ~(1ULL << (state & 63));
+    }
+    seeds.clear();
+    std::sort(result.begin(), result.end());
+    return result;
+}
@@ -0,0 +1,120 @@
+/*
+ * File: lazyDFA.h
+ * Project: Lexer
+ * Author: MingLLuo
+ * Usage: Define the LazyDFA class, a DFA built on demand from an NFA
+ */
+#ifndef LEXICAL_LAZYDFA_H
+#define LEXICAL_LAZYDFA_H
+
+#include "dfa.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+
+/* LazyDFA: subset construction done one transition at a time while
+ * scanning; the NFA side (edges by byte class, epsilon closures, token
+ * kinds) is read-only and shared, the DFA states live in a Cache that one
+ * thread owns. A Cache holds at most maxStates states and is flushed when
+ * it is full, so memory stays bounded whatever the patterns are
+ */
+class LazyDFA {
+  public:
+    // same values as in CompiledDFA, a scanner can take either
+    static constexpr int32_t DEAD = -1;
+    static constexpr int32_t NO_KIND = -1;
+    static constexpr int alphabet = 256;
+
+    class Cache;
+    class Lease;
+
+    // token kinds, sorted by name like CompiledDFA::kinds
+    std::vector<std::string> kinds;
+    int32_t classCount = 0;
+    std::array<uint8_t, alphabet> classMap{};
+
+    LazyDFA(std::shared_ptr<NFA> nfa, size_t maxStates);
+
+    [[nodiscard]] size_t maxStates() const { return limit; }
+
+    std::unique_ptr<Cache> acquire() const;
+    void release(std::unique_ptr<Cache> cache) const;
+
+  private:
+    std::shared_ptr<NFA> nfa;
+    EpsilonClosure closures;
+    std::vector<uint32_t> startSet;
+    // (byte class, target) of every NFA state, epsilon edges left out
+    std::vector<std::vector<std::pair<uint8_t, uint32_t>>> edges;
+    std::map<std::string, int32_t> kindIndex;
+    size_t limit;
+
+    // caches not in use, taken by acquire and given back by release
+    mutable std::mutex poolMutex;
+    mutable std::vector<std::unique_ptr<Cache>> pool;
+};
+
+/* LazyDFA::Cache: the states built so far, state 0 is the start state;
+ * next[state * classCount + class] is a state, DEAD, or UNKNOWN until the
+ * transition is first taken. Not thread safe
+ */
+class LazyDFA::Cache {
+  public:
+    static constexpr int32_t UNKNOWN = -2;
+
+    const int32_t start = 0;
+    std::vector<int32_t> accept;
+    // times the cache was full and started over
+    size_t flushes = 0;
+
+    explicit Cache(const LazyDFA &dfa);
+
+    [[nodiscard]] int32_t step(int32_t state, unsigned char c) {
+        int32_t target =
+            next[static_cast<size_t>(state) * dfa.classCount + dfa.classMap[c]];
+        return target != UNKNOWN ? target : build(state, dfa.classMap[c]);
+    }
+
+    [[nodiscard]] size_t stateCount() const { return sets.size(); }
+
+    [[nodiscard]] int32_t match(std::string_view str);
+
+  private:
+    struct SetHash {
+        size_t operator()(const std::vector<uint32_t> &set) const;
+    };
+
+    int32_t build(int32_t state, uint8_t cls);
+    int32_t addState(std::vector<uint32_t> set);
+    void flush();
+    std::vector<uint32_t> closure();
+
+    const LazyDFA &dfa;
+    std::vector<int32_t> next;
+    std::vector<std::vector<uint32_t>> sets;
+    std::unordered_map<std::vector<uint32_t>, int32_t, SetHash> index;
+    // scratch of build: marked NFA states and targets before the closure
+    std::vector<uint64_t> mark;
+    std::vector<uint32_t> seeds;
+};
+
+/* LazyDFA::Lease: a cache acquired for the lifetime of the lease */
+class LazyDFA::Lease {
+  public:
+    explicit Lease(const LazyDFA &dfa) : dfa(dfa), cache(dfa.acquire()) {}
+
+    ~Lease() { dfa.release(std::move(cache)); }
+
+    Lease(const Lease &) = delete;
+    Lease &operator=(const Lease &) = delete;
+
+    Cache &operator*() const { return *cache; }
+
+  private:
+    const LazyDFA &dfa;
+    std::unique_ptr<Cache> cache;
+};
+
+#endif // LEXICAL_LAZYDFA_H
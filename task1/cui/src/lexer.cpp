@@ -5,74 +5,499 @@
  * Usage: Define the Lexer class
  */
 #include "lexer.h"
+#include <algorithm>
+#include <future>
+#include <thread>
+#include <unordered_set>
 
-/* lexerInit: initialize lexer */
+/* withAutomaton: call f with the automaton that matches tokens, the
+ * CompiledDFA or a cache of lazyDFA held for the call
+ */
+template <typename F> auto Lexer::withAutomaton(F &&f) const {
+  if (lazyDFA == nullptr) {
+    return f(compiledDFA);
+  }
+  LazyDFA::Lease lease(*lazyDFA);
+  return f(*lease);
+}
+
+/* lexerInit: initialize lexer, the DFAs are loaded from the cache of
+ * options.cacheDir if it holds them for this pattern text, else they are
+ * built and saved there; in lazy mode nothing is cached
+ */
 void Lexer::lexerInit() {
-  std::vector<std::shared_ptr<RegExp>> keywords, symbols;
-  auto keywordNFA = std::make_shared<NFA>();
-  auto symbolNFA = std::make_shared<NFA>();
-  for (const auto &keyword : pattern.keywordsToRegScanner()) {
-    if (keyword.empty()) {
-      continue;
+  if (options.lazyStates > 0) {
+    buildLazy();
+  } else {
+    lazyDFA = nullptr;
+    std::string key = cacheKey();
+    std::string cachePath;
+    if (!options.cacheDir.empty()) {
+      cachePath = automatonCachePath(options.cacheDir, key);
     }
-    auto regExp = stringToRegExp(keyword);
-    keywords.push_back(regExp);
-    auto nfa = regExp->toNFA();
-    nfa->setFinalStatus(keyword);
-    keywordNFA = unionNFAs(keywordNFA, nfa);
-  }
-  for (const auto &symbol : pattern.specialSymbolsToRegScanner()) {
-    // special for symbols
-    if (symbol.empty()) {
-      continue;
+    if (cachePath.empty() || !loadAutomata(cachePath, key, dfas, finalDFA)) {
+      buildAutomata();
+      if (!cachePath.empty()) {
+        saveAutomata(cachePath, key, dfas, finalDFA);
+      }
     }
-    auto regExp = std::make_shared<RegExp>(symbol);
-    symbols.push_back(regExp);
-    auto nfa = regExp->toNFA();
-    nfa->setFinalStatus(symbol);
-    symbolNFA = unionNFAs(symbolNFA, nfa);
-  }
-  if (!keywords.empty()) {
-    if (keywords.size() == 1) {
-      regExps["keyword"] = keywords[0];
-    } else {
-      regExps["keyword"] =
-          std::make_shared<RegExp>(keywords, RegExp::Type::Union);
+    compiledDFA = CompiledDFA(*finalDFA);
+  }
+  prepareKeywords();
+  prepareScan();
+}
+
+/* cacheKey: text the cached automata depend on, the patterns and the
+ * options that change finalDFA
+ */
+std::string Lexer::cacheKey() const {
+  if (options.keywordHash) {
+    return pattern.source + "\n#keywordHash\n";
+  }
+  return pattern.source;
+}
+
+/* hashedKeywords: keywords left to the perfect hash, the ones idDFA accepts
+ * @param idDFA: DFA of the id category
+ * @return: keywords in order, empty unless options.keywordHash
+ */
+std::vector<std::string> Lexer::hashedKeywords(const DFA &idDFA) const {
+  std::vector<std::string> result;
+  if (!options.keywordHash) {
+    return result;
+  }
+  CompiledDFA id(idDFA);
+  for (const auto &keyword : pattern.keywordsToRegScanner()) {
+    if (!keyword.empty() && id.match(keyword) != CompiledDFA::NO_KIND) {
+      result.push_back(keyword);
     }
   }
-  if (!symbols.empty()) {
-    if (symbols.size() == 1) {
-      regExps["symbol"] = symbols[0];
-    } else {
-      regExps["symbol"] =
-          std::make_shared<RegExp>(symbols, RegExp::Type::Union);
+  return result;
+}
+
+/* prepareKeywords: build keywordHash, a hashed keyword gets its own kind
+ * appended to compiledDFA.kinds; every kind finalDFA gives to a keyword
+ * lexeme is marked in reclassify, a token of such a kind is looked up
+ */
+void Lexer::prepareKeywords() {
+  std::vector<std::pair<std::string, int32_t>> entries;
+  std::vector<int32_t> matched;
+  std::vector<std::string> hashed;
+  if (options.keywordHash) {
+    hashed = hashedKeywords(*dfas.at("id"));
+  }
+  for (const auto &keyword : hashed) {
+    matched.push_back(
+        withAutomaton([&](auto &dfa) { return dfa.match(keyword); }));
+    auto &kinds = compiledDFA.kinds;
+    auto it = std::find(kinds.begin(), kinds.end(), keyword);
+    if (it == kinds.end()) {
+      it = kinds.insert(kinds.end(), keyword);
     }
+    entries.emplace_back(keyword, static_cast<int32_t>(it - kinds.begin()));
   }
+  reclassify.assign(compiledDFA.kinds.size(), 0);
+  for (int32_t kind : matched) {
+    if (kind != CompiledDFA::NO_KIND) {
+      reclassify[kind] = 1;
+    }
+  }
+  keywordHash = KeywordHash(entries);
+}
+
+/* parseRegExps: parse the id, num and comment regular expressions */
+void Lexer::parseRegExps() {
   regExps["id"] = stringToRegExp(pattern.idRegexToRegScanner());
   regExps["num"] = stringToRegExp(pattern.numRegexToRegScanner());
   regExps["comment"] = stringToRegExp(pattern.commentRegexToRegScanner());
+}
+
+/* categoryDFA: minimized DFA of one parsed category
+ * @param name: id, num or comment
+ */
+std::shared_ptr<DFA> Lexer::categoryDFA(const std::string &name) const {
+  auto dfa = convertToDFA(regExps.at(name)->toNFA())->minimizeDFA();
+  dfa->setFinalStatus(name);
+  return dfa;
+}
+
+/* buildFinalNFA: union of every token, keywords and symbols are literals
+ * and each set becomes a prefix trie, a literal being its own status
+ * @param hashed: keywords left to the perfect hash, not in the NFA
+ * @return: NFA of finalDFA
+ */
+std::shared_ptr<NFA>
+Lexer::buildFinalNFA(const std::vector<std::string> &hashed) const {
+  std::unordered_set<std::string> skip(hashed.begin(), hashed.end());
+  std::vector<std::string> keywords;
+  for (const auto &keyword : pattern.keywordsToRegScanner()) {
+    if (skip.count(keyword) == 0) {
+      keywords.push_back(keyword);
+    }
+  }
+  std::vector<std::string> symbols = pattern.specialSymbolsToRegScanner();
+  auto nfa = unionNFAs(literalTrieNFA(keywords, keywords),
+                       literalTrieNFA(symbols, symbols));
+  for (const char *name : {"id", "num", "comment"}) {
+    auto part = regExps.at(name)->toNFA();
+    part->setFinalStatus(name);
+    nfa = unionNFAs(nfa, part);
+  }
+  return nfa;
+}
+
+/* buildAutomata: build dfas and finalDFA from the patterns; every category
+ * and the final DFA are constructed on their own thread. A task builds the
+ * NFAs it needs from the shared, read-only RegExps and literals, since the
+ * combinators consume their operands, so startup costs about as much as
+ * the slowest construction. With options.keywordHash the final DFA waits
+ * for the id DFA, which tells the keywords to leave out
+ */
+void Lexer::buildAutomata() {
+  parseRegExps();
+  std::vector<std::string> keywords = pattern.keywordsToRegScanner();
+  std::vector<std::string> symbols = pattern.specialSymbolsToRegScanner();
+
+  auto keywordDFA = std::async(std::launch::async, [&] {
+    return convertToDFA(literalTrieNFA(keywords, keywords));
+  });
+  auto symbolDFA = std::async(std::launch::async, [&] {
+    return convertToDFA(literalTrieNFA(symbols, symbols));
+  });
+  auto category = [this](const std::string &name) {
+    return categoryDFA(name);
+  };
+  // shared with the final DFA, which leaves the hashed keywords out
+  auto idDFA = std::async(std::launch::async, category, "id").share();
+  auto numDFA = std::async(std::launch::async, category, "num");
+  auto commentDFA = std::async(std::launch::async, category, "comment");
+  auto final = std::async(std::launch::async, [&] {
+    auto finalNFA = buildFinalNFA(hashedKeywords(*idDFA.get()));
+    return convertToDFA(finalNFA)->minimizeDFA();
+  });
+
+  dfas["keyword"] = keywordDFA.get();
+  dfas["symbol"] = symbolDFA.get();
+  dfas["id"] = idDFA.get();
+  dfas["num"] = numDFA.get();
+  dfas["comment"] = commentDFA.get();
+  finalDFA = final.get();
+}
+
+/* buildLazy: build only the final NFA and a LazyDFA over it, no DFA is
+ * constructed up front except the id DFA that keywordHash needs
+ */
+void Lexer::buildLazy() {
+  parseRegExps();
+  dfas.clear();
+  finalDFA = nullptr;
+  std::vector<std::string> hashed;
+  if (options.keywordHash) {
+    dfas["id"] = categoryDFA("id");
+    hashed = hashedKeywords(*dfas["id"]);
+  }
+  lazyDFA =
+      std::make_shared<LazyDFA>(buildFinalNFA(hashed), options.lazyStates);
+  compiledDFA = CompiledDFA();
+  compiledDFA.kinds = lazyDFA->kinds;
+}
+
+/* scan: maximal munch over input, every token is the longest prefix that
+ * reaches an accepting state, the DFA rolls back to the last one seen;
+ * whitespace runs and comment bodies take the vectorized paths of scanSkip
+ * @param base: offset of input[0] in the whole stream
+ * @param atEnd: input is the end of the stream; if not, scanning stops
+ * before a token that may continue past the end of input
+ * @param from: position of the first token in input
+ * @param limit: no token is started at or after limit
+ * @return: position in input where scanning stopped
+ */
+size_t Lexer::scan(std::string_view input, size_t base, bool atEnd,
+                   const TokenHandler &handler, size_t from,
+                   size_t limit) const {
+  return withAutomaton([&](auto &dfa) {
+    return scanWith(dfa, input, base, atEnd, handler, from, limit);
+  });
+}
+
+/* scanWith: scan with dfa, a CompiledDFA or a LazyDFA cache */
+template <typename Automaton>
+size_t Lexer::scanWith(Automaton &dfa, std::string_view input, size_t base,
+                       bool atEnd, const TokenHandler &handler, size_t from,
+                       size_t limit) const {
+  const char *data = input.data();
+  const char *end = data + input.size();
+  size_t pos = from;
+  limit = std::min(limit, input.size());
+  while (pos < limit) {
+    if (skipSpaces && isSpaceByte(data[pos])) {
+      pos = skipWhitespace(data + pos, end) - data;
+      continue;
+    }
+
+    // comment bodies are found with memchr / find instead of the DFA
+    std::string_view rest = input.substr(pos);
+    if (commentKind != LexToken::ERROR_KIND) {
+      const char *close = nullptr;
+      if (!pattern.comment.empty() &&
+          rest.substr(0, pattern.comment.size()) == pattern.comment) {
+        close = findLineEnd(data + pos + pattern.comment.size(), end);
+        if (close == end && !atEnd)
+          return pos;
+      } else if (!pattern.lcomment.empty() &&
+                 rest.substr(0, pattern.lcomment.size()) == pattern.lcomment) {
+        close = findDelimiter(data + pos + pattern.lcomment.size(), end,
+                              pattern.rcomment);
+        if (close == nullptr && !atEnd)
+          return pos;
+        if (close != nullptr)
+          close += pattern.rcomment.size();
+      }
+      if (close != nullptr) {
+        size_t length = close - (data + pos);
+        handler({commentKind, base + pos, length}, rest.substr(0, length));
+        pos += length;
+        continue;
+      }
+    }
+
+    int32_t state = dfa.start;
+    int32_t kind = LexToken::ERROR_KIND;
+    size_t length = 0;
+    size_t i = pos;
+    while (state != CompiledDFA::DEAD && i < input.size()) {
+      state = dfa.step(state, static_cast<unsigned char>(input[i++]));
+      if (state != CompiledDFA::DEAD &&
+          dfa.accept[state] != CompiledDFA::NO_KIND) {
+        kind = dfa.accept[state];
+        length = i - pos;
+      }
+    }
+    if (state != CompiledDFA::DEAD && !atEnd) {
+      // the token may go on in the next block
+      return pos;
+    }
+    if (length > 0 && reclassify[kind]) {
+      int32_t keyword = keywordHash.find(input.substr(pos, length));
+      if (keyword != KeywordHash::NONE) {
+        kind = keyword;
+      }
+    }
+    if (length > 0) {
+      handler({kind, base + pos, length}, input.substr(pos, length));
+      pos += length;
+    } else if (pattern.isWhitespace(input[pos])) {
+      pos++;
+    } else {
+      handler({LexToken::ERROR_KIND, base + pos, 1}, input.substr(pos, 1));
+      pos++;
+    }
+  }
+  return pos;
+}
+
+/* prepareScan: decide which fast paths scan may take, whitespace runs are
+ * skipped in bulk only if no token starts with a space byte
+ */
+void Lexer::prepareScan() {
+  skipSpaces = !compiledDFA.empty() || lazyDFA != nullptr;
+  withAutomaton([&](auto &dfa) {
+    for (char c : {' ', '\t', '\n', '\r'}) {
+      if (skipSpaces && dfa.step(dfa.start, static_cast<unsigned char>(c)) !=
+                            CompiledDFA::DEAD) {
+        skipSpaces = false;
+      }
+    }
+  });
+  commentKind = LexToken::ERROR_KIND;
+  auto it =
+      std::find(compiledDFA.kinds.begin(), compiledDFA.kinds.end(), "comment");
+  if (it != compiledDFA.kinds.end() &&
+      (!pattern.comment.empty() || !pattern.rcomment.empty())) {
+    commentKind = static_cast<int32_t>(it - compiledDFA.kinds.begin());
+  }
+}
+
+/* tokenize: split input into tokens, whitespace between tokens is skipped
+ * @param input: text to tokenize
+ * @return: tokens, offsets are relative to input
+ */
+std::vector<LexToken> Lexer::tokenize(std::string_view input) const {
+  std::vector<LexToken> tokens;
+  tokenize(input, [&](const LexToken &token, std::string_view) {
+    tokens.push_back(token);
+  });
+  return tokens;
+}
+
+/* tokenize: split input into tokens in place, e.g. over a MappedFile
+ * @param input: text to tokenize
+ * @param handler: called for every token with its lexeme, a view of input
+ */
+void Lexer::tokenize(std::string_view input,
+                     const TokenHandler &handler) const {
+  scan(input, 0, true, handler);
+}
+
+/* tokenizeParallel: tokenizeParallel with a handler, tokens are collected
+ * @return: tokens, same as tokenize(input)
+ */
+std::vector<LexToken> Lexer::tokenizeParallel(std::string_view input,
+                                              unsigned threads) const {
+  std::vector<LexToken> tokens;
+  tokenizeParallel(
+      input,
+      [&](const LexToken &token, std::string_view) { tokens.push_back(token); },
+      threads);
+  return tokens;
+}
 
-  // convert keyword NFA to DFA
-  dfas["keyword"] = convertToDFA(keywordNFA);
-  dfas["symbol"] = convertToDFA(symbolNFA);
-  dfas["id"] = convertToDFA(regExps["id"]->toNFA())->minimizeDFA();
-  dfas["id"]->setFinalStatus("id");
-  dfas["num"] = convertToDFA(regExps["num"]->toNFA())->minimizeDFA();
-  dfas["num"]->setFinalStatus("num");
-  dfas["comment"] = convertToDFA(regExps["comment"]->toNFA())->minimizeDFA();
-  dfas["comment"]->setFinalStatus("comment");
-
-  // finalDFA
-  auto finalNFA = unionNFAs(keywordNFA, symbolNFA);
-  auto nfa = regExps["id"]->toNFA();
-  nfa->setFinalStatus("id");
-  finalNFA = unionNFAs(finalNFA, nfa);
-  nfa = regExps["num"]->toNFA();
-  nfa->setFinalStatus("num");
-  finalNFA = unionNFAs(finalNFA, nfa);
-  nfa = regExps["comment"]->toNFA();
-  nfa->setFinalStatus("comment");
-  finalNFA = unionNFAs(finalNFA, nfa);
-  finalDFA = convertToDFA(finalNFA);
-  finalDFA = finalDFA->minimizeDFA();
-}
\ No newline at end of file
+/* tokenizeParallel: split input into chunks and scan every chunk on its own
+ * thread, guessing that a token starts at the first byte of the chunk.
+ * After a token boundary the DFA restarts from its start state, so once the
+ * true scan reaches a token the guess also started, both agree on the rest
+ * of the chunk. The chunks are stitched in order: the true scan is rerun
+ * from where the previous chunk really ended until it meets a guessed token,
+ * usually after one or two tokens. The handler sees the same tokens as
+ * tokenize(input), in order and on the calling thread.
+ * @param threads: count of chunks, 0 for one per hardware thread
+ */
+void Lexer::tokenizeParallel(std::string_view input,
+                             const TokenHandler &handler,
+                             unsigned threads) const {
+  // below this a chunk is not worth a thread
+  constexpr size_t minChunk = 1 << 20;
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  size_t chunks = std::min<size_t>(threads, input.size() / minChunk);
+  if (chunks < 2) {
+    tokenize(input, handler);
+    return;
+  }
+
+  struct Chunk {
+    size_t begin;
+    size_t end;
+    // tokens of the guessed scan and where it stopped
+    std::vector<LexToken> tokens;
+    size_t stop = 0;
+  };
+  std::vector<Chunk> parts(chunks);
+  for (size_t k = 0; k < chunks; k++) {
+    parts[k].begin = input.size() / chunks * k;
+    parts[k].end =
+        k + 1 == chunks ? input.size() : input.size() / chunks * (k + 1);
+  }
+  std::vector<std::thread> workers;
+  workers.reserve(chunks - 1);
+  for (size_t k = 1; k < chunks; k++) {
+    workers.emplace_back([&, k] {
+      Chunk &part = parts[k];
+      part.stop = scan(
+          input, 0, true,
+          [&](const LexToken &token, std::string_view) {
+            part.tokens.push_back(token);
+          },
+          part.begin, part.end);
+    });
+  }
+
+  // the first chunk starts at a real token boundary, scan it right away
+  size_t pos = scan(input, 0, true, handler, 0, parts[0].end);
+  for (size_t k = 1; k < chunks; k++) {
+    workers[k - 1].join();
+    Chunk &part = parts[k];
+    if (pos >= part.end)
+      continue;
+    size_t i = 0;
+    while (true) {
+      while (i < part.tokens.size() && part.tokens[i].offset < pos) {
+        i++;
+      }
+      if (i == part.tokens.size()) {
+        // never met: finish the chunk with the true scan
+        pos = scan(input, 0, true, handler, pos, part.end);
+        break;
+      }
+      if (part.tokens[i].offset == pos) {
+        for (; i < part.tokens.size(); i++) {
+          const LexToken &token = part.tokens[i];
+          handler(token, input.substr(token.offset, token.length));
+        }
+        pos = part.stop;
+        break;
+      }
+      pos = scan(input, 0, true, handler, pos, part.tokens[i].offset);
+    }
+    std::vector<LexToken>().swap(part.tokens);
+  }
+}
+
+/* toTokenStream: tokenize input into the binary format read by the parser
+ * @param input: text to tokenize
+ * @return: tokens with their lexemes and lines, kinds are compiledDFA.kinds
+ */
+TokenStream Lexer::toTokenStream(std::string_view input) const {
+  TokenStream stream;
+  stream.kinds = compiledDFA.kinds;
+  uint32_t line = 1;
+  size_t counted = 0;
+  tokenizeParallel(input, [&](const LexToken &token, std::string_view lexeme) {
+    line += std::count(input.begin() + counted, input.begin() + token.offset,
+                       '\n');
+    counted = token.offset;
+    stream.add(static_cast<uint32_t>(token.kind), line, lexeme);
+  });
+  return stream;
+}
+
+/* tokenize: split a stream into tokens
+ * @param input: stream to tokenize
+ * @return: tokens, offsets are relative to the start of the stream
+ */
+std::vector<LexToken> Lexer::tokenize(std::istream &input) const {
+  std::vector<LexToken> tokens;
+  tokenize(input, [&](const LexToken &token, std::string_view) {
+    tokens.push_back(token);
+  });
+  return tokens;
+}
+
+/* tokenize: split a stream into tokens block by block, only the unfinished
+ * token at the end of a block is kept for the next one
+ * @param input: stream to tokenize
+ * @param handler: called for every token with its lexeme, the lexeme is
+ * only valid during the call
+ */
+void Lexer::tokenize(std::istream &input, const TokenHandler &handler) const {
+  constexpr size_t blockSize = 1 << 16;
+  std::string buffer;
+  size_t base = 0;
+  bool atEnd = false;
+  while (!atEnd) {
+    size_t kept = buffer.size();
+    buffer.resize(kept + blockSize);
+    input.read(buffer.data() + kept, blockSize);
+    buffer.resize(kept + static_cast<size_t>(input.gcount()));
+    atEnd = !input;
+    size_t consumed = scan(buffer, base, atEnd, handler);
+    buffer.erase(0, consumed);
+    base += consumed;
+  }
+}
+
+/* tokenToString: token in the text format read by the parser
+ * @param lexeme: text of the token
+ * @return: "Token: kind" or "Token: id -> lexeme" for id and num
+ */
+std::string Lexer::tokenToString(const LexToken &token,
+                                 std::string_view lexeme) const {
+  if (token.kind == LexToken::ERROR_KIND) {
+    return "Invalid token: " + std::string(lexeme);
+  }
+  const std::string &kind = compiledDFA.kinds[token.kind];
+  if (kind == "id" || kind == "num") {
+    return "Token: " + kind + " -> " + std::string(lexeme);
+  }
+  return "Token: " + kind;
+}
@@ -6,14 +6,51 @@
  */
 #ifndef LEXER_H
 #define LEXER_H
+#include "automatonCache.h"
+#include "compiledDFA.h"
 #include "dfa.h"
+#include "keywordHash.h"
+#include "lazyDFA.h"
 #include "pattern.h"
 #include "regExp.h"
+#include "scanSkip.h"
+#include "tokenStream.h"
+#include <functional>
+#include <string_view>
+
+/* LexToken: one token of the input, kind indexes compiledDFA.kinds or is
+ * ERROR_KIND for a byte no token can start with
+ */
+struct LexToken {
+  static constexpr int32_t ERROR_KIND = -1;
+  int32_t kind;
+  size_t offset;
+  size_t length;
+};
+
+using TokenHandler =
+    std::function<void(const LexToken &token, std::string_view lexeme)>;
+
+/* LexerOptions: how a Lexer builds its automata
+ * cacheDir: directory of the automaton cache, empty to always build
+ * keywordHash: keywords the id DFA accepts are left out of finalDFA, an
+ * identifier is reclassified through a perfect hash of them instead
+ * lazyStates: 0 builds finalDFA up front; otherwise only the final NFA is
+ * built and scanned with a LazyDFA caching at most that many states
+ */
+struct LexerOptions {
+  std::string cacheDir;
+  bool keywordHash = false;
+  size_t lazyStates = 0;
+};
+
 class Lexer {
 public:
   void lexerInit();
 
-  Lexer(std::string s, const std::string &filePath) : pattern(s, filePath) {
+  Lexer(std::string s, const std::string &filePath,
+        LexerOptions lexerOptions = {})
+      : pattern(s, filePath), options(std::move(lexerOptions)) {
     lexerInit();
   }
   Lexer() = default;
@@ -23,11 +60,58 @@ public:
   }
 
   std::string generateLexer();
+
+  std::vector<LexToken> tokenize(std::string_view input) const;
+  void tokenize(std::string_view input, const TokenHandler &handler) const;
+  std::vector<LexToken> tokenizeParallel(std::string_view input,
+                                         unsigned threads = 0) const;
+  void tokenizeParallel(std::string_view input, const TokenHandler &handler,
+                        unsigned threads = 0) const;
+  TokenStream toTokenStream(std::string_view input) const;
+  std::vector<LexToken> tokenize(std::istream &input) const;
+  void tokenize(std::istream &input, const TokenHandler &handler) const;
+  std::string tokenToString(const LexToken &token,
+                            std::string_view lexeme) const;
   Pattern pattern;
+  LexerOptions options;
 
+  // only built when the automata do not come from the cache
   std::map<std::string, std::shared_ptr<RegExp>> regExps;
   std::map<std::string, std::shared_ptr<DFA>> dfas;
   std::shared_ptr<DFA> finalDFA;
+  // table form of finalDFA, used for matching; in lazy mode it only has
+  // the kinds, and lazyDFA matches instead
+  CompiledDFA compiledDFA;
+  std::shared_ptr<LazyDFA> lazyDFA;
+
+  // fast paths of the scanner, set by prepareScan: whitespace runs can be
+  // skipped in bulk, and the kind of comment tokens (or ERROR_KIND)
+  bool skipSpaces = false;
+  int32_t commentKind = LexToken::ERROR_KIND;
+  // keywords left out of finalDFA, and the kinds their lexemes are matched
+  // as by finalDFA (usually only id), set by prepareKeywords
+  KeywordHash keywordHash;
+  std::vector<char> reclassify;
+
+private:
+  void parseRegExps();
+  std::shared_ptr<DFA> categoryDFA(const std::string &name) const;
+  std::shared_ptr<NFA>
+  buildFinalNFA(const std::vector<std::string> &hashed) const;
+  void buildAutomata();
+  void buildLazy();
+  std::string cacheKey() const;
+  std::vector<std::string> hashedKeywords(const DFA &idDFA) const;
+  void prepareKeywords();
+  void prepareScan();
+  template <typename F> auto withAutomaton(F &&f) const;
+  size_t scan(std::string_view input, size_t base, bool atEnd,
+              const TokenHandler &handler, size_t from = 0,
+              size_t limit = std::string_view::npos) const;
+  template <typename Automaton>
+  size_t scanWith(Automaton &dfa, std::string_view input, size_t base,
+                  bool atEnd, const TokenHandler &handler, size_t from,
+                  size_t limit) const;
 };
 
 #endif // LEXER_H
\ No newline at end of file
@@ -0,0 +1,50 @@
+/*
+ * File: mappedFile.h
+ * Project: Lexer
+ * Author: MingLLuo
+ * Usage: Define the MappedFile class, read-only view of a whole file
+ */
+#ifndef LEXICAL_MAPPEDFILE_H
+#define LEXICAL_MAPPEDFILE_H
+
+#include <string>
+#include <string_view>
+
+/* MappedFile: a regular file is mapped with mmap, anything else (pipes,
+ * terminals, or a failed mmap) is read() into an owned buffer
+ */
+class MappedFile {
+  public:
+    MappedFile() = default;
+
+    explicit MappedFile(const std::string &path) { open(path); }
+
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    bool open(const std::string &path);
+    bool openDescriptor(int fd);
+    void close();
+
+    [[nodiscard]] bool isOpen() const { return opened; }
+    [[nodiscard]] bool isMapped() const { return mapped != nullptr; }
+    [[nodiscard]] const char *data() const {
+        return mapped != nullptr ? mapped : buffer.data();
+    }
+    [[nodiscard]] size_t size() const {
+        return mapped != nullptr ? length : buffer.size();
+    }
+    [[nodiscard]] std::string_view view() const { return {data(), size()}; }
+
+  private:
+    const char *mapped = nullptr;
+    size_t length = 0;
+    std::string buffer;
+    bool opened = false;
+};
+
+#endif // LEXICAL_MAPPEDFILE_H
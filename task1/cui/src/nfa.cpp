@@ -5,87 +5,189 @@
  * Usage: Define the NFA class
  */
 #include "nfa.h"
+#include <algorithm>
 
-/* NFA: constructor */
-NFA::NFA() : start_state(nullptr) { this->symbols.insert(0); }
+/* addState: add a new state at the end of the arena
+ * @param final_state: the new state is final or not
+ * @return: index of the new state
+ */
+uint32_t NFA::addState(bool final_state) {
+    auto id = static_cast<uint32_t>(states.size());
+    states.emplace_back(id, final_state);
+    return id;
+}
 
-/* mergeStatesFromNFA: merge states from nfa to this
- * @param nfa: nfa to merge
+/* addTransition: add transition from -- symbol --> to
+ * @param symbol: input symbol, 0 for epsilon
  */
-void NFA::mergeStatesFromNFA(const std::shared_ptr<NFA> &nfa) {
-    // move all states of nfa to this, won't copy start state
-    for (const auto &state : nfa->states) {
-        states.insert(state);
-    }
-    // copy symbol table
-    copySymbols(nfa);
+void NFA::addTransition(uint32_t from, char symbol, uint32_t to) {
+    auto byte = static_cast<unsigned char>(symbol);
+    states[from].transitions.push_back({byte, byte, to});
+}
+
+/* addRange: add transition from -- [lo, hi] --> to
+ * @param lo: first byte, at least 1
+ * @param hi: last byte, at least lo
+ */
+void NFA::addRange(uint32_t from, unsigned char lo, unsigned char hi,
+                   uint32_t to) {
+    states[from].transitions.push_back({lo, hi, to});
 }
 
-/* copySymbols: copy symbols from nfa to this
-  * @param nfa: nfa to copy
-  */
-void NFA::copySymbols(const std::shared_ptr<NFA> &nfa) {
-    for (auto symbol : nfa->symbols) {
-        symbols.insert(symbol);
+/* addETransitions: add epsilon transitions from src_list to dest
+ * @param src_list: source states
+ * @param dest: destination state
+ */
+void NFA::addETransitions(const std::vector<uint32_t> &src_list,
+                          uint32_t dest) {
+    for (auto state : src_list) {
+        // Add epsilon transitions: state -- 0 -> dest
+        states[state].transitions.push_back({0, 0, dest});
     }
 }
 
-/* copyCleanNFA: copy nfa to this, with or without final states
- * @param nfa: nfa to copy
- * @param withFinal: copy final states or not
+/* append: move all states of nfa to the end of this arena, nfa is left
+ * empty, won't touch the start state of this
+ * @param nfa: nfa to move
+ * @return: new index of the start state of nfa
  */
-void NFA::copyCleanNFA(const std::shared_ptr<NFA> &nfa, bool withFinal) {
-    copySymbols(nfa);
-    flush();
-    std::map<std::shared_ptr<NFAState>, std::shared_ptr<NFAState>> state_map;
-    for (const auto &state : nfa->states) {
-        auto new_state = std::make_shared<NFAState>(fresh());
-        if (withFinal && state->is_final) {
-            new_state->is_final = true;
-            new_state->final_status = state->final_status;
+uint32_t NFA::append(NFA &&nfa) {
+    auto offset = static_cast<uint32_t>(states.size());
+    states.reserve(states.size() + nfa.states.size());
+    for (auto &state : nfa.states) {
+        state.id += offset;
+        for (auto &edge : state.transitions) {
+            edge.to += offset;
         }
-        // use old transitions first
-        new_state->transitions = state->transitions;
-
-        this->states.insert(new_state);
-        state_map[state] = new_state;
+        states.push_back(std::move(state));
     }
-    for (const auto &state : this->states) {
-        for (const auto &transition : state->transitions) {
-            std::set<std::shared_ptr<NFAState>> new_nextStates;
-            for (const auto &oldNext_state : transition.second) {
-                if (state_map.find(oldNext_state) == state_map.end()) {
-                    new_nextStates.insert(oldNext_state);
-                } else {
-                    new_nextStates.insert(state_map[oldNext_state]);
-                }
-            }
-            state->transitions[transition.first] = new_nextStates;
-        }
+    uint32_t start = nfa.empty() ? NONE : nfa.start_state + offset;
+    nfa.states.clear();
+    nfa.start_state = NONE;
+    return start;
+}
+
+/* finalStates: indices of all final states */
+std::vector<uint32_t> NFA::finalStates() const {
+    std::vector<uint32_t> result;
+    for (const auto &state : states) {
+        if (state.is_final)
+            result.push_back(state.id);
     }
-    start_state = state_map[nfa->start_state];
+    return result;
 }
 
 /* setFinalStatus: set final status for all final states
  * @param str: final status
  */
-void NFA::setFinalStatus(const std::string &str) const {
-    for (const auto &state : states) {
-        if (state->is_final) {
-            state->final_status = str;
+void NFA::setFinalStatus(const std::string &str) {
+    for (auto &state : states) {
+        if (state.is_final) {
+            state.final_status = str;
         }
     }
 }
 
-/* addETransitions: add epsilon transitions from src_list to dest
- * @param src_list: source states
- * @param dest: destination state
+/* EpsilonClosure: constructor, Tarjan's algorithm without recursion,
+ * components are completed sinks first, so every successor component is
+ * already closed when a component is finished
+ * @param nfa: NFA to close
  */
-void addETransitions(const std::vector<std::shared_ptr<NFAState>> &src_list,
-                     const std::shared_ptr<NFAState> &dest) {
-    for (const auto &state : src_list) {
-        // Add epsilon transitions: state -- 0 -> dest
-        state->transitions[0].insert(dest);
+EpsilonClosure::EpsilonClosure(const NFA &nfa) {
+    const auto n = static_cast<uint32_t>(nfa.states.size());
+    const uint32_t unvisited = NFA::NONE;
+    std::vector<uint32_t> order(n, unvisited), low(n, 0);
+    std::vector<char> onStack(n, 0);
+    std::vector<uint32_t> tarjanStack;
+    // call stack of (state, next edge to look at)
+    std::vector<std::pair<uint32_t, size_t>> callStack;
+    component.assign(n, unvisited);
+    offsets.push_back(0);
+
+    std::vector<uint64_t> mark((n + 63) / 64, 0);
+    std::vector<uint32_t> closure;
+    uint32_t counter = 0;
+    uint32_t components = 0;
+
+    for (uint32_t root = 0; root < n; root++) {
+        if (order[root] != unvisited)
+            continue;
+        callStack.emplace_back(root, 0);
+        order[root] = low[root] = counter++;
+        tarjanStack.push_back(root);
+        onStack[root] = 1;
+
+        while (!callStack.empty()) {
+            auto &[state, edge] = callStack.back();
+            const auto &transitions = nfa.states[state].transitions;
+            bool descended = false;
+            while (edge < transitions.size()) {
+                const NFAEdge &e = transitions[edge++];
+                if (!e.isEpsilon())
+                    continue;
+                if (order[e.to] == unvisited) {
+                    order[e.to] = low[e.to] = counter++;
+                    tarjanStack.push_back(e.to);
+                    onStack[e.to] = 1;
+                    callStack.emplace_back(e.to, 0);
+                    descended = true;
+                    break;
+                }
+                if (onStack[e.to])
+                    low[state] = std::min(low[state], order[e.to]);
+            }
+            if (descended)
+                continue;
+
+            uint32_t current = state;
+            callStack.pop_back();
+            if (!callStack.empty()) {
+                uint32_t parent = callStack.back().first;
+                low[parent] = std::min(low[parent], low[current]);
+            }
+            if (low[current] != order[current])
+                continue;
+
+            // current is the root of a component: pop it, then merge its
+            // members with the closures of the components it reaches
+            size_t first = tarjanStack.size();
+            do {
+                first--;
+            } while (tarjanStack[first] != current);
+            closure.clear();
+            auto add = [&](uint32_t member) {
+                uint64_t bit = 1ULL << (member & 63);
+                if (!(mark[member >> 6] & bit)) {
+                    mark[member >> 6] |= bit;
+                    closure.push_back(member);
+                }
+            };
+            for (size_t i = first; i < tarjanStack.size(); i++) {
+                uint32_t member = tarjanStack[i];
+                onStack[member] = 0;
+                component[member] = components;
+                add(member);
+            }
+            for (size_t i = first; i < tarjanStack.size(); i++) {
+                for (const auto &e : nfa.states[tarjanStack[i]].transitions) {
+                    if (!e.isEpsilon() || component[e.to] == components)
+                        continue;
+                    size_t from = offsets[component[e.to]];
+                    size_t to = offsets[component[e.to] + 1];
+                    for (size_t j = from; j < to; j++) {
+                        add(members[j]);
+                    }
+                }
+            }
+            tarjanStack.resize(first);
+            std::sort(closure.begin(), closure.end());
+            for (uint32_t member : closure) {
+                mark[member >> 6] &= ~(1ULL << (member & 63));
+            }
+            members.insert(members.end(), closure.begin(), closure.end());
+            offsets.push_back(members.size());
+            components++;
+        }
     }
 }
 
@@ -94,120 +196,131 @@ void addETransitions(const std::vector<std::shared_ptr<NFAState>> &src_list,
  * @param nfa2: second NFA
  * @return: concatenated NFA
  */
-std::shared_ptr<NFA> concatNFAs(const std::shared_ptr<NFA> &nfa1,
-                                const std::shared_ptr<NFA> &nfa2) {
-    auto nfaConcat = std::make_shared<NFA>();
-    // Copy states from nfa1
-    nfaConcat->copyCleanNFA(nfa1, true);
-
-    auto copy_nfa2 = std::make_shared<NFA>();
-    copy_nfa2->copyCleanNFA(nfa2, true);
-
-    // Add epsilon transitions from final states of nfa1 to nfa2's start state
-    for (const auto &state : nfaConcat->states) {
-        if (state->is_final)
-            addETransitions({state}, copy_nfa2->start_state);
-        state->is_final = false;
+std::shared_ptr<NFA> concatNFAs(std::shared_ptr<NFA> nfa1,
+                                std::shared_ptr<NFA> nfa2) {
+    auto finals = nfa1->finalStates();
+    for (auto state : finals) {
+        nfa1->states[state].is_final = false;
     }
-
-    // Copy states from nfa2
-    nfaConcat->mergeStatesFromNFA(copy_nfa2);
-
-    return nfaConcat;
+    // Add epsilon transitions from final states of nfa1 to nfa2's start state
+    uint32_t start2 = nfa1->append(std::move(*nfa2));
+    nfa1->addETransitions(finals, start2);
+    return nfa1;
 }
 
-/* unionNFAs: union two NFAs
+/* unionNFAs: union two NFAs, an empty operand is the identity
  * @param nfa1: first NFA
  * @param nfa2: second NFA
  * @return: union NFA
  */
-std::shared_ptr<NFA> unionNFAs(const std::shared_ptr<NFA> &nfa1,
-                               const std::shared_ptr<NFA> &nfa2) {
-    auto nfaUnion = std::make_shared<NFA>();
-    auto copy_nfa1 = std::make_shared<NFA>();
-    auto copy_nfa2 = std::make_shared<NFA>();
-    copy_nfa1->copyCleanNFA(nfa1, true);
-    copy_nfa2->copyCleanNFA(nfa2, true);
-
-    auto start_state = std::make_shared<NFAState>(fresh());
-    nfaUnion->states.insert(start_state);
-    nfaUnion->start_state = start_state;
+std::shared_ptr<NFA> unionNFAs(std::shared_ptr<NFA> nfa1,
+                               std::shared_ptr<NFA> nfa2) {
+    if (nfa2->empty())
+        return nfa1;
+    if (nfa1->empty())
+        return nfa2;
+    uint32_t start1 = nfa1->start_state;
+    uint32_t start2 = nfa1->append(std::move(*nfa2));
 
     // Add epsilon transitions from the new start state to the start states of
     // nfa1 and nfa2
-    addETransitions({start_state}, copy_nfa1->start_state);
-    addETransitions({start_state}, copy_nfa2->start_state);
-    nfaUnion->mergeStatesFromNFA(copy_nfa1);
-    nfaUnion->mergeStatesFromNFA(copy_nfa2);
-    return nfaUnion;
+    nfa1->start_state = nfa1->addState();
+    nfa1->addETransitions({nfa1->start_state}, start1);
+    nfa1->addETransitions({nfa1->start_state}, start2);
+    return nfa1;
 }
 
 /* starNFA: create a star NFA
  * @param nfa: NFA to create star
  * @return: star NFA
  */
-std::shared_ptr<NFA> starNFA(const std::shared_ptr<NFA> &nfa) {
-    auto nfaStar = std::make_shared<NFA>();
-
-    // Copy states from the original NFA
-    nfaStar->copyCleanNFA(nfa, true);
-
+std::shared_ptr<NFA> starNFA(std::shared_ptr<NFA> nfa) {
     //  Add epsilon transitions to the original start state
-    for (const auto &state : nfaStar->states) {
-        if (state->is_final && state != nfaStar->start_state)
-            addETransitions({state}, nfaStar->start_state);
+    for (auto state : nfa->finalStates()) {
+        if (state != nfa->start_state)
+            nfa->addETransitions({state}, nfa->start_state);
     }
     // must add after add e, or a new e will be added
-    nfaStar->start_state->is_final = true;
-    nfaStar->start_state->final_status = nfaStar->start_state->final_status;
-    return nfaStar;
+    nfa->states[nfa->start_state].is_final = true;
+    return nfa;
 }
 
-std::shared_ptr<NFA> plusNFA(const std::shared_ptr<NFA> &nfa) {
-    auto nfaPlus = std::make_shared<NFA>();
-
-    // Copy states from the original NFA
-    nfaPlus->copyCleanNFA(nfa, true);
-    // Create a new start state and
+/* plusNFA: create a plus NFA
+ * @param nfa: NFA to create plus
+ * @return: plus NFA
+ */
+std::shared_ptr<NFA> plusNFA(std::shared_ptr<NFA> nfa) {
+    auto finals = nfa->finalStates();
+    // Create a new end state and
     // add epsilon transitions to the original start state
-    auto endState = std::make_shared<NFAState>(fresh(), true);
-
-    for (const auto &state : nfaPlus->states) {
-        if (state->is_final)
-            addETransitions({state}, endState);
-        state->is_final = false;
+    uint32_t endState = nfa->addState(true);
+    for (auto state : finals) {
+        nfa->states[state].is_final = false;
     }
-    addETransitions({endState}, nfaPlus->start_state);
-    nfaPlus->states.insert(endState);
-
-    return nfaPlus;
+    nfa->addETransitions(finals, endState);
+    nfa->addETransitions({endState}, nfa->start_state);
+    return nfa;
 }
 
 /* quesNFA: create a question mark NFA
  * @param nfa: NFA to create question mark
  * @return: question mark NFA
  */
-std::shared_ptr<NFA> quesNFA(const std::shared_ptr<NFA> &nfa) {
-    auto nfaQues = std::make_shared<NFA>();
+std::shared_ptr<NFA> quesNFA(std::shared_ptr<NFA> nfa) {
+    auto finals = nfa->finalStates();
+    uint32_t start_state = nfa->addState();
+    uint32_t final_state = nfa->addState(true);
 
-    nfaQues->copyCleanNFA(nfa, true);
+    nfa->addETransitions({start_state}, nfa->start_state);
+    nfa->addETransitions({start_state}, final_state);
 
-    auto start_state = std::make_shared<NFAState>(fresh());
-    auto final_state = std::make_shared<NFAState>(fresh(), true);
-
-    addETransitions({start_state}, nfaQues->start_state);
-    addETransitions({start_state}, final_state);
-
-    for (const auto &state : nfaQues->states) {
-        if (state->is_final)
-            addETransitions({state}, final_state);
-        state->is_final = false;
+    for (auto state : finals) {
+        nfa->states[state].is_final = false;
     }
+    nfa->addETransitions(finals, final_state);
+    nfa->start_state = start_state;
+    return nfa;
+}
 
-    nfaQues->states.insert(start_state);
-    nfaQues->states.insert(final_state);
-    nfaQues->start_state = start_state;
-    return nfaQues;
+/* literalTrieNFA: one state per distinct prefix of the literals, so the
+ * NFA is already deterministic and has no epsilon transitions; the state
+ * ending a literal is final, a duplicate literal keeps the first status
+ * @param literals: strings to accept, empty ones are skipped
+ * @param status: final status of every literal
+ * @return: trie NFA, empty if no literal is left
+ */
+std::shared_ptr<NFA> literalTrieNFA(const std::vector<std::string> &literals,
+                                    const std::vector<std::string> &status) {
+    auto nfa = std::make_shared<NFA>();
+    for (size_t i = 0; i < literals.size(); i++) {
+        if (literals[i].empty())
+            continue;
+        if (nfa->empty())
+            nfa->start_state = nfa->addState();
+        uint32_t state = nfa->start_state;
+        for (char c : literals[i]) {
+            // at most one edge per byte, the scan is bounded by the alphabet
+            auto byte = static_cast<unsigned char>(c);
+            auto &edges = nfa->states[state].transitions;
+            auto edge = std::find_if(edges.begin(), edges.end(),
+                                     [byte](const NFAEdge &e) {
+                                         return e.lo == byte;
+                                     });
+            if (edge != edges.end()) {
+                state = edge->to;
+            } else {
+                uint32_t next = nfa->addState();
+                nfa->addTransition(state, c, next);
+                state = next;
+            }
+        }
+        NFAState &end = nfa->states[state];
+        if (!end.is_final) {
+            end.is_final = true;
+            end.final_status = status[i];
+        }
+    }
+    return nfa;
 }
 
 /* printNFA: print NFA
@@ -215,23 +328,25 @@ std::shared_ptr<NFA> quesNFA(const std::shared_ptr<NFA> &nfa) {
  */
 void printNFA(const NFA &nfa) {
     std::cout << "NFA States:\n";
-    std::cout << "NFA Start State:" << nfa.start_state->id << '\n';
+    std::cout << "NFA Start State:" << nfa.start_state << '\n';
     for (const auto &state : nfa.states) {
-        std::cout << "State " << state->id;
-        if (state->is_final)
+        std::cout << "State " << state.id;
+        if (state.is_final)
             std::cout << " (Final)";
         std::cout << "\n";
-        for (const auto &transition : state->transitions) {
-            for (const auto &nextState : transition.second) {
-                if (transition.first == 0) {
-                    std::cout << state->id << " --- "
-                              << "esp"
-                              << " --> " << nextState->id << '\n';
-                } else {
-                    std::cout << state->id << " --- " << transition.first
-                              << " --> " << nextState->id << '\n';
-                }
+        for (const auto &transition : state.transitions) {
+            if (transition.isEpsilon()) {
+                std::cout << state.id << " --- "
+                          << "esp"
+                          << " --> " << transition.to << '\n';
+            } else if (transition.lo == transition.hi) {
+                std::cout << state.id << " --- " << transition.lo << " --> "
+                          << transition.to << '\n';
+            } else {
+                std::cout << state.id << " --- " << transition.lo << "-"
+                          << transition.hi << " --> " << transition.to
+                          << '\n';
             }
         }
     }
-}
\ No newline at end of file
+}
@@ -6,54 +6,111 @@
  */
 #ifndef NFA_H
 #define NFA_H
-#include "util.h"
+#include <cstdint>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <vector>
+
+/* NFAEdge: transition on any byte of [lo, hi] to state `to` of the same
+ * NFA, hi 0 marks an epsilon edge since byte 0 is never a symbol
+ */
+struct NFAEdge {
+    unsigned char lo;
+    unsigned char hi;
+    uint32_t to;
+
+    [[nodiscard]] bool isEpsilon() const { return hi == 0; }
+};
 
 class NFAState {
   public:
-    int id;
+    uint32_t id;
     bool is_final;
     std::string final_status;
-    std::unordered_map<char, std::set<std::shared_ptr<NFAState>>> transitions;
+    std::vector<NFAEdge> transitions;
 
-    explicit NFAState(int state_id, bool final_state = false)
+    explicit NFAState(uint32_t state_id, bool final_state = false)
         : id(state_id), is_final(final_state) {}
 };
 
+/* NFAFragment: partial automaton inside one NFA arena, outs are the
+ * states still to be linked to whatever follows the fragment
+ */
+struct NFAFragment {
+    uint32_t start;
+    std::vector<uint32_t> outs;
+};
+
+/* NFA: arena of states, a state is addressed by its index in states and
+ * its id is always equal to that index
+ */
 class NFA {
   public:
-    std::set<std::shared_ptr<NFAState>> states;
-    std::shared_ptr<NFAState> start_state;
-    std::set<char> symbols;
+    static constexpr uint32_t NONE = UINT32_MAX;
 
-    NFA();
+    std::vector<NFAState> states;
+    uint32_t start_state = NONE;
+
+    NFA() = default;
 
     ~NFA() = default;
 
-    void mergeStatesFromNFA(const std::shared_ptr<NFA> &nfa);
+    [[nodiscard]] bool empty() const { return start_state == NONE; }
+
+    uint32_t addState(bool final_state = false);
+    void addTransition(uint32_t from, char symbol, uint32_t to);
+    void addRange(uint32_t from, unsigned char lo, unsigned char hi,
+                  uint32_t to);
+    void addETransitions(const std::vector<uint32_t> &src_list,
+                         uint32_t dest);
+    uint32_t append(NFA &&nfa);
+    [[nodiscard]] std::vector<uint32_t> finalStates() const;
+
+    void setFinalStatus(const std::string &str);
+};
+
+/* EpsilonClosure: epsilon closure of every state of one NFA, computed once
+ * by condensing the epsilon graph into strongly connected components and
+ * merging the closures of successor components in topological order;
+ * states of one component share a single sorted member list
+ */
+class EpsilonClosure {
+  public:
+    explicit EpsilonClosure(const NFA &nfa);
 
-    void copyCleanNFA(const std::shared_ptr<NFA> &nfa, bool withFinal);
+    [[nodiscard]] const uint32_t *begin(uint32_t state) const {
+        return members.data() + offsets[component[state]];
+    }
+    [[nodiscard]] const uint32_t *end(uint32_t state) const {
+        return members.data() + offsets[component[state] + 1];
+    }
 
-    void copySymbols(const std::shared_ptr<NFA> &nfa);
-    void setFinalStatus(const std::string &str) const;
+  private:
+    std::vector<uint32_t> component;
+    std::vector<size_t> offsets;
+    std::vector<uint32_t> members;
 };
 
-void addETransitions(const std::vector<std::shared_ptr<NFAState>> &src_list,
-                     const std::shared_ptr<NFAState> &dest);
+// combinators consume their operands: the states of the operands are moved
+// into the result, which reuses the arena of the first operand
+std::shared_ptr<NFA> concatNFAs(std::shared_ptr<NFA> nfa1,
+                                std::shared_ptr<NFA> nfa2);
+
+std::shared_ptr<NFA> unionNFAs(std::shared_ptr<NFA> nfa1,
+                               std::shared_ptr<NFA> nfa2);
+std::shared_ptr<NFA> starNFA(std::shared_ptr<NFA> nfa);
 
-std::shared_ptr<NFA> concatNFAs(const std::shared_ptr<NFA> &nfa1,
-                                const std::shared_ptr<NFA> &nfa2);
+std::shared_ptr<NFA> plusNFA(std::shared_ptr<NFA> nfa);
+std::shared_ptr<NFA> quesNFA(std::shared_ptr<NFA> nfa);
 
-std::shared_ptr<NFA> unionNFAs(const std::shared_ptr<NFA> &nfa1,
-                               const std::shared_ptr<NFA> &nfa2);
-std::shared_ptr<NFA> starNFA(const std::shared_ptr<NFA> &nfa);
+// deterministic prefix trie of literal strings, built in linear time
+std::shared_ptr<NFA> literalTrieNFA(const std::vector<std::string> &literals,
+                                    const std::vector<std::string> &status);
 
-std::shared_ptr<NFA> plusNFA(const std::shared_ptr<NFA> &nfa);
-std::shared_ptr<NFA> quesNFA(const std::shared_ptr<NFA> &nfa);
+void printNFA(const NFA &nfa);
 
-#endif
\ No newline at end of file
+#endif
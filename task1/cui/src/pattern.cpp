@@ -5,6 +5,7 @@
  * Usage: Define the Pattern class
  */
 #include "pattern.h"
+#include "mappedFile.h"
 #include <string>
 
 /* loadPatterns: read file and call readPatterns
@@ -12,13 +13,8 @@
  */
 void Pattern::loadPatterns(const std::string &filePath) {
   // readfile then readPatterns
-  std::ifstream file(filePath);
-  std::string content;
-  std::string line;
-  while (std::getline(file, line)) {
-    content += line + "\n";
-  }
-  readPatterns(content);
+  MappedFile file(filePath);
+  readPatterns(std::string(file.view()));
 }
 
 /* readPatterns: read patterns from string, if 'rules' exists, read rules till
@@ -26,6 +22,7 @@ void Pattern::loadPatterns(const std::string &filePath) {
  * @param s: string
  */
 void Pattern::readPatterns(std::string s) {
+  source = s;
   // split to vector
   std::vector<std::string> lines;
   std::istringstream iss(s);
@@ -84,7 +81,7 @@ void Pattern::readPatterns(std::string s) {
     if (type == "rules:") {
       // read to end of file
       std::string rule;
-      while (i < lines.size()) {
+      while (i + 1 < lines.size()) {
         i++;
         rule = lines[i];
         if (rule.empty()) {
@@ -242,30 +239,25 @@ std::vector<std::string> Pattern::specialSymbolsToRegScanner() const {
   return result;
 }
 
-/* vectorToRegex: convert vector to regex
- * @param vec: vector
+/* vectorToRegex: convert vector to a character class
+ * @param vec: member chars, in any order
  * @return: string
  */
 std::string vectorToRegex(const std::vector<char> &vec) {
-  std::string result;
-  if (vec.size() > 1) {
-    for (int i = 0; i < vec.size(); i++) {
-      result += vec[i];
-      if (i != vec.size() - 1) {
-        result += "|";
-      }
+  std::string members;
+  for (int c = 1; c < 256; c++) {
+    if (std::find(vec.begin(), vec.end(), static_cast<char>(c)) != vec.end()) {
+      members += static_cast<char>(c);
     }
-  } else {
-    result = vec[0];
   }
-  return result;
+  return charClassToRegex(members);
 }
 
 /* idRegexToRegScanner: convert idRegex to regex
  * @return: string
  */
 std::string Pattern::idRegexToRegScanner() const {
-  // make l -> (letters| letters ...), d -> (digits| digits ...)
+  // make l -> [letters], d -> [digits]
   std::string result;
   std::string letters = vectorToRegex(this->letters);
   std::string digits = vectorToRegex(this->digits);
@@ -315,27 +307,28 @@ std::string Pattern::commentRegexToRegScanner() const {
   std::string result;
   // make all char except left and right comment to vector of char (or comment)
   std::vector<char> all;
-  for (int i = 0; i < 128; i++) {
+  for (int i = 1; i < 128; i++) {
     if (comment == "") {
       if (i != lcomment[0] && i != rcomment[0]) {
-        if ((std::isprint(i) || isspace(i)) && !isTypeChar(i)) {
+        if (std::isprint(i) || isspace(i)) {
           all.push_back(i);
         }
       }
     } else {
       // if comment is not empty, add all char except comment
       if (comment.find(i) == std::string::npos) {
-        if ((std::isprint(i) || isspace(i)) && !isTypeChar(i) && i != '\n') {
+        if ((std::isprint(i) || isspace(i)) && i != '\n') {
           all.push_back(i);
         }
       }
     }
   }
-  // std::string all = letters + "|" + digits + "|" + space;
+  // one class instead of a union of every char
   if (lcomment == "") {
-    result = comment + vectorToRegex(all) + "*";
+    result = escapeRegex(comment) + vectorToRegex(all) + "*";
   } else {
-    result = lcomment + vectorToRegex(all) + "*" + rcomment;
+    result = escapeRegex(lcomment) + vectorToRegex(all) + "*" +
+             escapeRegex(rcomment);
   }
   return result;
 }
\ No newline at end of file
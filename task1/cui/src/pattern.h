@@ -7,6 +7,7 @@
 #ifndef PATTERN_H
 #define PATTERN_H
 #include "regScanner.h"
+#include <algorithm>
 #include <fstream>
 #include <map>
 #include <set>
@@ -24,6 +25,8 @@ public:
   std::string idRegex;
   std::string numRegex;
   std::set<std::string> allTokens;
+  // text the patterns were read from
+  std::string source;
 
   Pattern() = default;
   Pattern(std::string s, const std::string &filePath) {
@@ -66,6 +66,13 @@ std::shared_ptr<RegExp> tokensToRegExp(const std::vector<Token> &tokens) {
                    precedence(operatorStack.top()) == 0)
                 applyOperator();
             break;
+        case TokenType::CharClass:
+            regexStack.push(std::make_shared<RegExp>(RegExp::Type::CharClass,
+                                                     token.charSet));
+            while (operatorStack.size() > 1 &&
+                   precedence(operatorStack.top()) == 0)
+                applyOperator();
+            break;
         case TokenType::Epsilon:
             regexStack.push(std::make_shared<RegExp>());
             while (operatorStack.size() > 1 &&
@@ -155,62 +162,100 @@ std::shared_ptr<RegExp> stringToRegExp(const std::string &s) {
     return tokensToRegExp(tokens);
 }
 
+/* toNFA: Thompson construction of this RegExp into a fresh NFA with one
+ * final state
+ * @return: NFA
+ */
 std::shared_ptr<NFA> RegExp::toNFA() const {
+    auto nfa = std::make_shared<NFA>();
+    NFAFragment fragment = toFragment(*nfa);
+    nfa->start_state = fragment.start;
+    nfa->addETransitions(fragment.outs, nfa->addState(true));
+    return nfa;
+}
+
+/* joinOuts: outs of both fragments, the larger list is reused */
+static std::vector<uint32_t> joinOuts(std::vector<uint32_t> outs1,
+                                      std::vector<uint32_t> outs2) {
+    if (outs1.size() < outs2.size())
+        std::swap(outs1, outs2);
+    outs1.insert(outs1.end(), outs2.begin(), outs2.end());
+    return outs1;
+}
+
+/* toFragment: emit this RegExp into nfa in one pass, every state is added
+ * once and never copied
+ * @param nfa: NFA arena to emit into
+ * @return: fragment with the start state and dangling outs
+ */
+NFAFragment RegExp::toFragment(NFA &nfa) const {
     switch (type) {
     case Type::EmptyString: {
-        auto nfa = std::make_shared<NFA>();
-        auto start_state = std::make_shared<NFAState>(fresh());
-        auto final_state = std::make_shared<NFAState>(fresh(), true);
-        start_state->transitions[0].insert(final_state);
-        nfa->states.insert(start_state);
-        nfa->states.insert(final_state);
-        nfa->start_state = start_state;
-        return nfa;
+        uint32_t state = nfa.addState();
+        return {state, {state}};
     }
     case Type::Char: {
-        auto nfa = std::make_shared<NFA>();
-        auto start_state = std::make_shared<NFAState>(fresh());
-        auto final_state = std::make_shared<NFAState>(fresh(), true);
-        start_state->transitions[c].insert(final_state);
-        nfa->states.insert(start_state);
-        nfa->states.insert(final_state);
-        nfa->start_state = start_state;
-        nfa->symbols.insert(c);
-        return nfa;
+        uint32_t start_state = nfa.addState();
+        uint32_t final_state = nfa.addState();
+        nfa.addTransition(start_state, c, final_state);
+        return {start_state, {final_state}};
+    }
+    case Type::CharClass: {
+        // one state pair for the whole class, one edge per run of bytes
+        uint32_t start_state = nfa.addState();
+        uint32_t final_state = nfa.addState();
+        for (size_t i = 0; i < chars.size();) {
+            auto lo = static_cast<unsigned char>(chars[i]);
+            auto hi = lo;
+            while (++i < chars.size() &&
+                   static_cast<unsigned char>(chars[i]) == hi + 1) {
+                hi++;
+            }
+            nfa.addRange(start_state, lo, hi, final_state);
+        }
+        return {start_state, {final_state}};
     }
     case Type::Union: {
-        auto nfa1 = left->toNFA();
-        auto nfa2 = right->toNFA();
-        auto result = unionNFAs(nfa1, nfa2);
-        return result;
+        NFAFragment f1 = left->toFragment(nfa);
+        NFAFragment f2 = right->toFragment(nfa);
+        uint32_t start_state = nfa.addState();
+        nfa.addETransitions({start_state}, f1.start);
+        nfa.addETransitions({start_state}, f2.start);
+        return {start_state, joinOuts(std::move(f1.outs), std::move(f2.outs))};
     }
     case Type::Concat: {
-        auto nfa1 = left->toNFA();
-        auto nfa2 = right->toNFA();
-        auto result = concatNFAs(nfa1, nfa2);
-        return result;
+        NFAFragment f1 = left->toFragment(nfa);
+        NFAFragment f2 = right->toFragment(nfa);
+        nfa.addETransitions(f1.outs, f2.start);
+        return {f1.start, std::move(f2.outs)};
     }
     case Type::Star: {
-        auto nfa = right->toNFA();
-        auto result = starNFA(nfa);
-        return result;
+        NFAFragment f = right->toFragment(nfa);
+        uint32_t loop = nfa.addState();
+        nfa.addETransitions({loop}, f.start);
+        nfa.addETransitions(f.outs, loop);
+        return {loop, {loop}};
     }
     case Type::Plus: {
-        // without minimize
-        auto nfa = right->toNFA();
-        auto result = plusNFA(nfa);
-        return result;
+        NFAFragment f = right->toFragment(nfa);
+        uint32_t loop = nfa.addState();
+        nfa.addETransitions(f.outs, loop);
+        nfa.addETransitions({loop}, f.start);
+        return {f.start, {loop}};
     }
     case Type::Ques: {
-        auto nfa = right->toNFA();
-        auto result = quesNFA(nfa);
-        return result;
+        NFAFragment f = right->toFragment(nfa);
+        uint32_t skip = nfa.addState();
+        nfa.addETransitions({skip}, f.start);
+        f.outs.push_back(skip);
+        return {skip, std::move(f.outs)};
     }
 
     default:
-        return nullptr;
+        throw std::runtime_error("Invalid RegExp type");
     }
 }
+
 std::string spaces(int count) { return std::string(count, ' '); }
 
 std::string regExpToString(const std::shared_ptr<RegExp> &regExp) {
@@ -220,7 +265,9 @@ std::string regExpToString(const std::shared_ptr<RegExp> &regExp) {
     case RegExp::Type::EmptyString:
         return "";
     case RegExp::Type::Char:
-        return std::string(1, regExp->c);
+        return escapeRegex(std::string(1, regExp->c));
+    case RegExp::Type::CharClass:
+        return charClassToRegex(regExp->chars);
     case RegExp::Type::Union:
         return "(" + regExpToString(regExp->right) + "|" +
                regExpToString(regExp->left) + ")";
@@ -248,6 +295,8 @@ std::string regExpToStringWithSpace(int space,
         return "[Empty]";
     case RegExp::Type::Char:
         return spaces(space) + std::string(1, regExp->c) + "\n";
+    case RegExp::Type::CharClass:
+        return spaces(space) + charClassToRegex(regExp->chars) + "\n";
     case RegExp::Type::Union:
         return spaces(space) + "op(|)\n" +
                regExpToStringWithSpace(space + 2, regExp->left) +
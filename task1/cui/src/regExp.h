@@ -15,6 +15,7 @@ class RegExp {
     enum class Type {
         EmptyString, // Epsilon
         Char,
+        CharClass, // any byte of chars
         Union,
         Ques,
         Concat,
@@ -40,6 +41,10 @@ class RegExp {
 
     RegExp(Type t) : type(t), c('\0'), left(nullptr), right(nullptr) {}
 
+    RegExp(Type t, std::string members)
+        : type(t), c('\0'), chars(std::move(members)), left(nullptr),
+          right(nullptr) {}
+
     RegExp(std::shared_ptr<RegExp> l, std::shared_ptr<RegExp> r, Type t)
         : type(t), c('\0'), left(std::move(l)), right(std::move(r)) {}
 
@@ -74,9 +79,12 @@ class RegExp {
     ~RegExp() = default;
 
     [[nodiscard]] std::shared_ptr<NFA> toNFA() const;
+    NFAFragment toFragment(NFA &nfa) const;
 
     Type type;
     char c;
+    // members of a CharClass, in increasing order
+    std::string chars;
     std::shared_ptr<RegExp> left;
     std::shared_ptr<RegExp> right;
 };
@@ -31,6 +31,12 @@ Token Scanner::getNextTokenFromStr() {
     case ')':
         ++pos;
         return {TokenType::RParen};
+    case '[':
+        ++pos;
+        return charClass();
+    case '\\':
+        ++pos;
+        return {TokenType::Char, escaped()};
     default:
         if (currentChar) {
             ++pos;
@@ -41,6 +47,88 @@ Token Scanner::getNextTokenFromStr() {
     }
 }
 
+/* hexValue: value of a hex digit, or -1 */
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+/* escaped: the byte of the escape sequence after a backslash, \n \t \r \f
+ * and \xHH are control bytes, any other char stands for itself
+ * @return: escaped byte
+ */
+char Scanner::escaped() {
+    if (pos >= str.length())
+        throw std::runtime_error("Escape at end of input");
+    char c = str[pos++];
+    switch (c) {
+    case 'n':
+        return '\n';
+    case 't':
+        return '\t';
+    case 'r':
+        return '\r';
+    case 'f':
+        return '\f';
+    case 'x': {
+        int high = pos < str.length() ? hexValue(str[pos]) : -1;
+        int low = pos + 1 < str.length() ? hexValue(str[pos + 1]) : -1;
+        if (high < 0 || low < 0 || (high == 0 && low == 0))
+            throw std::runtime_error("Invalid \\x escape");
+        pos += 2;
+        return static_cast<char>(high * 16 + low);
+    }
+    default:
+        return c;
+    }
+}
+
+/* charClass: scan a class after its '[': single bytes, ranges a-z and
+ * escapes, a leading '^' takes the complement; '\0' is left out since it
+ * is the epsilon symbol of the NFA
+ * @return: CharClass token
+ */
+Token Scanner::charClass() {
+    bool members[256] = {};
+    bool negate = pos < str.length() && str[pos] == '^';
+    if (negate)
+        ++pos;
+    while (pos < str.length() && str[pos] != ']') {
+        char first = str[pos++];
+        if (first == '\\')
+            first = escaped();
+        char last = first;
+        if (pos + 1 < str.length() && str[pos] == '-' && str[pos + 1] != ']') {
+            ++pos;
+            last = str[pos++];
+            if (last == '\\')
+                last = escaped();
+        }
+        auto from = static_cast<unsigned char>(first);
+        auto to = static_cast<unsigned char>(last);
+        if (from > to)
+            throw std::runtime_error("Invalid range in character class");
+        for (int c = from; c <= to; c++) {
+            members[c] = true;
+        }
+    }
+    if (pos >= str.length())
+        throw std::runtime_error("Unterminated character class");
+    ++pos; // ']'
+
+    std::string set;
+    for (int c = 1; c < 256; c++) {
+        if (members[c] != negate)
+            set += static_cast<char>(c);
+    }
+    return {TokenType::CharClass, set};
+}
+
 // Function to tokenize input string
 std::vector<Token> regTokenize(const std::string &str) {
     std::vector<Token> tokens;
@@ -61,6 +149,10 @@ void regTokenPrint(const std::vector<Token> &tokens) {
         case TokenType::Char:
             std::cout << "Char: " << token.value << std::endl;
             break;
+        case TokenType::CharClass:
+            std::cout << "CharClass: " << charClassToRegex(token.charSet)
+                      << std::endl;
+            break;
         case TokenType::Concat:
             std::cout << "Concat" << std::endl;
             break;
@@ -94,8 +186,71 @@ void regTokenPrint(const std::vector<Token> &tokens) {
 
 bool isTypeChar(char c) {
     if (c == '|' || c == '*' || c == '+' || c == '?' || c == '(' || c == ')' ||
-        c == '\0') {
+        c == '[' || c == ']' || c == '\\' || c == '\0') {
         return true;
     }
     return false;
+}
+
+/* escapeChar: c as the scanner reads it back, special chars inside a
+ * class are escaped when inClass
+ */
+static std::string escapeChar(char c, bool inClass) {
+    switch (c) {
+    case '\n':
+        return "\\n";
+    case '\t':
+        return "\\t";
+    case '\r':
+        return "\\r";
+    case '\f':
+        return "\\f";
+    default:
+        break;
+    }
+    auto byte = static_cast<unsigned char>(c);
+    if (byte < 0x20 || byte >= 0x7f) {
+        const char *hex = "0123456789abcdef";
+        return std::string("\\x") + hex[byte >> 4] + hex[byte & 15];
+    }
+    bool special = inClass ? c == ']' || c == '\\' || c == '^' || c == '-'
+                           : isTypeChar(c);
+    return special ? std::string("\\") + c : std::string(1, c);
+}
+
+/* escapeRegex: literal as a regex matching exactly it
+ * @param literal: string to match
+ * @return: regex with the type chars escaped
+ */
+std::string escapeRegex(const std::string &literal) {
+    std::string result;
+    for (char c : literal) {
+        result += escapeChar(c, false);
+    }
+    return result;
+}
+
+/* charClassToRegex: class syntax for a set of bytes, runs of three or
+ * more bytes are written as ranges
+ * @param members: member bytes in increasing order
+ * @return: class like [_a-z]
+ */
+std::string charClassToRegex(const std::string &members) {
+    std::string result = "[";
+    for (size_t i = 0; i < members.size();) {
+        size_t j = i;
+        while (j + 1 < members.size() &&
+               static_cast<unsigned char>(members[j + 1]) ==
+                   static_cast<unsigned char>(members[j]) + 1) {
+            j++;
+        }
+        result += escapeChar(members[i], true);
+        if (j >= i + 2) {
+            result += "-" + escapeChar(members[j], true);
+            i = j + 1;
+        } else {
+            i++;
+        }
+    }
+    return result + "]";
 }
\ No newline at end of file
@@ -13,6 +13,7 @@
 
 enum class TokenType {
     Char,
+    CharClass,
     Concat,
     Epsilon,
     Union,
@@ -24,6 +25,9 @@ enum class TokenType {
     END
 };
 
+/* Token: value is the byte of a Char, charSet the member bytes of a
+ * CharClass in increasing order, '\0' is never a member
+ */
 struct Token {
     TokenType type;
     char value{};
@@ -43,12 +47,17 @@ public:
     Token getNextTokenFromStr();
 
 private:
+    char escaped();
+    Token charClass();
+
     std::string str;
     size_t pos;
 };
 
 std::vector<Token> regTokenize(const std::string &str);
 bool isTypeChar(char c);
+std::string escapeRegex(const std::string &literal);
+std::string charClassToRegex(const std::string &members);
 void regTokenPrint(const std::vector<Token> &tokens);
 
 #endif
@@ -0,0 +1,80 @@
+/*
+ * File: scanSkip.h
+ * Project: Lexer
+ * Author: MingLLuo
+ * Usage: Vectorized skipping of whitespace runs and comment bodies
+ */
+#ifndef LEXICAL_SCANSKIP_H
+#define LEXICAL_SCANSKIP_H
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/* isSpaceByte: ' ', '\t', '\n' or '\r', same set as Pattern::isWhitespace */
+inline bool isSpaceByte(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/* skipWhitespace: first byte in [p, end) that is not a space byte
+ * 32 / 16 bytes are compared at a time with AVX2 / SSE2, the tail and
+ * other targets use the scalar loop
+ */
+inline const char *skipWhitespace(const char *p, const char *end) {
+#if defined(__AVX2__)
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        __m256i hit = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, space),
+                            _mm256_cmpeq_epi8(v, tab)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, newline),
+                            _mm256_cmpeq_epi8(v, cr)));
+        auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+        if (mask != 0xffffffffu)
+            return p + __builtin_ctz(~mask);
+        p += 32;
+    }
+#elif defined(__SSE2__)
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i hit = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, newline), _mm_cmpeq_epi8(v, cr)));
+        auto mask = static_cast<uint32_t>(_mm_movemask_epi8(hit));
+        if (mask != 0xffffu)
+            return p + __builtin_ctz(~mask & 0xffffu);
+        p += 16;
+    }
+#endif
+    while (p < end && isSpaceByte(*p)) {
+        p++;
+    }
+    return p;
+}
+
+/* findLineEnd: the next '\n' in [p, end), or end */
+inline const char *findLineEnd(const char *p, const char *end) {
+    const void *found = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    return found != nullptr ? static_cast<const char *>(found) : end;
+}
+
+/* findDelimiter: start of the first delim in [p, end), or nullptr */
+inline const char *findDelimiter(const char *p, const char *end,
+                                 std::string_view delim) {
+    size_t found =
+        std::string_view(p, static_cast<size_t>(end - p)).find(delim);
+    return found == std::string_view::npos ? nullptr : p + found;
+}
+
+#endif // LEXICAL_SCANSKIP_H
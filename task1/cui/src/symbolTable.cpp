@@ -0,0 +1,69 @@
+/*
+ * File: symbolTable.cpp
+ * Project: Lexer
+ * Author: MingLLuo
+ * Usage: Define the SymbolTable class
+ */
+#include "symbolTable.h"
+#include <functional>
+#include <utility>
+
+/* SymbolTable: constructor from a stored pool, e.g. read from a file
+ * @param pool: all strings back to back
+ * @param offsets: start of every string in pool and the end of the last
+ */
+SymbolTable::SymbolTable(std::string pool, std::vector<uint32_t> offsets)
+    : pool(std::move(pool)), offsets(std::move(offsets)) {
+    if (this->offsets.empty())
+        this->offsets.push_back(0);
+    rehash(size());
+}
+
+/* intern: id of text, text is added to the pool if not there yet
+ * @param text: string to intern
+ * @return: id of text
+ */
+uint32_t SymbolTable::intern(std::string_view text) {
+    if ((size() + 1) * 2 > slots.size())
+        rehash(size() + 1);
+    size_t slot = slotOf(text);
+    if (slots[slot] == NONE) {
+        slots[slot] = static_cast<uint32_t>(size());
+        pool.append(text);
+        offsets.push_back(static_cast<uint32_t>(pool.size()));
+    }
+    return slots[slot];
+}
+
+/* find: id of text, or NONE if text was never interned */
+uint32_t SymbolTable::find(std::string_view text) const {
+    if (slots.empty())
+        return NONE;
+    return slots[slotOf(text)];
+}
+
+/* slotOf: slot that holds text, or the empty slot where it would go */
+size_t SymbolTable::slotOf(std::string_view text) const {
+    size_t mask = slots.size() - 1;
+    size_t slot = std::hash<std::string_view>{}(text) & mask;
+    while (slots[slot] != NONE && str(slots[slot]) != text) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/* rehash: grow slots so that count ids keep the table at most half full
+ * @param count: ids the table must hold
+ */
+void SymbolTable::rehash(size_t count) {
+    size_t capacity = 16;
+    while (capacity < count * 2) {
+        capacity *= 2;
+    }
+    if (capacity <= slots.size())
+        return;
+    slots.assign(capacity, NONE);
+    for (uint32_t id = 0; id < size(); id++) {
+        slots[slotOf(str(id))] = id;
+    }
+}
@@ -0,0 +1,52 @@
+/*
+ * File: symbolTable.h
+ * Project: Lexer
+ * Author: MingLLuo
+ * Usage: Define the SymbolTable class, interned lexemes
+ */
+#ifndef LEXICAL_SYMBOLTABLE_H
+#define LEXICAL_SYMBOLTABLE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* SymbolTable: string pool, every distinct string is stored once and named
+ * by a 32-bit id given in order of first appearance; symbol id is
+ * pool[offsets[id], offsets[id + 1]), lookup is an open addressing hash
+ * table of ids
+ */
+class SymbolTable {
+  public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    SymbolTable() = default;
+    SymbolTable(std::string pool, std::vector<uint32_t> offsets);
+
+    uint32_t intern(std::string_view text);
+    [[nodiscard]] uint32_t find(std::string_view text) const;
+
+    [[nodiscard]] std::string_view str(uint32_t id) const {
+        return std::string_view(pool).substr(offsets[id],
+                                             offsets[id + 1] - offsets[id]);
+    }
+    [[nodiscard]] uint32_t offset(uint32_t id) const { return offsets[id]; }
+    [[nodiscard]] size_t size() const { return offsets.size() - 1; }
+
+    [[nodiscard]] const std::string &data() const { return pool; }
+    [[nodiscard]] const std::vector<uint32_t> &bounds() const {
+        return offsets;
+    }
+
+  private:
+    std::string pool;
+    std::vector<uint32_t> offsets{0};
+    // id of every used slot or NONE, size is a power of two
+    std::vector<uint32_t> slots;
+
+    [[nodiscard]] size_t slotOf(std::string_view text) const;
+    void rehash(size_t capacity);
+};
+
+#endif // LEXICAL_SYMBOLTABLE_H
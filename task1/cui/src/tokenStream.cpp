@@ -0,0 +1,106 @@
+/*
+ * File: tokenStream.cpp
+ * Project: Lexer
+ * Author: MingLLuo
+ * Usage: Define the TokenStream class
+ */
+#include "tokenStream.h"
+#include "binaryIO.h"
+#include "mappedFile.h"
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+static constexpr std::string_view magic(tokenStreamMagic,
+                                        sizeof(tokenStreamMagic));
+
+/* add: append a token, its lexeme is interned
+ * @param kind: index in kinds, or ERROR_KIND
+ * @param line: line of the first byte of the token
+ */
+void TokenStream::add(uint32_t kind, uint32_t line, std::string_view lexeme) {
+    uint32_t symbol = symbols.intern(lexeme);
+    records.push_back({symbols.offset(symbol), kind,
+                       static_cast<uint32_t>(lexeme.size()), line, symbol});
+}
+
+/* serialize: the stream in binary form */
+std::string TokenStream::serialize() const {
+    std::string out;
+    std::vector<std::string_view> names(kinds.begin(), kinds.end());
+    writeTokenStream([&](const char *p, size_t n) { out.append(p, n); },
+                     names, records, symbols.bounds(), symbols.data());
+    return out;
+}
+
+/* deserialize: replace the stream with the one stored in data
+ * @return: false if data is not a valid stream of this version
+ */
+bool TokenStream::deserialize(std::string_view data) {
+    kinds.clear();
+    records.clear();
+    symbols = SymbolTable();
+    size_t pos = 0;
+    uint32_t fileVersion, kindCount, symbolCount;
+    uint64_t recordCount, poolSize;
+    if (data.substr(0, magic.size()) != magic)
+        return false;
+    pos += magic.size();
+    if (!getValue(data, pos, fileVersion) || fileVersion != version ||
+        !getValue(data, pos, kindCount) || !getValue(data, pos, symbolCount) ||
+        !getValue(data, pos, recordCount) || !getValue(data, pos, poolSize))
+        return false;
+    for (uint32_t i = 0; i < kindCount; i++) {
+        if (!getString(data, pos, kinds.emplace_back()))
+            return false;
+    }
+    pos = (pos + 7) / 8 * 8;
+    uint64_t offsetsSize = (uint64_t{symbolCount} + 1) * sizeof(uint32_t);
+    if (pos > data.size() ||
+        (data.size() - pos) / sizeof(TokenRecord) < recordCount ||
+        data.size() - pos - recordCount * sizeof(TokenRecord) !=
+            offsetsSize + poolSize)
+        return false;
+    records.resize(recordCount);
+    std::memcpy(records.data(), data.data() + pos,
+                recordCount * sizeof(TokenRecord));
+    pos += recordCount * sizeof(TokenRecord);
+    std::vector<uint32_t> offsets(symbolCount + 1);
+    std::memcpy(offsets.data(), data.data() + pos, offsetsSize);
+    pos += offsetsSize;
+    if (offsets.front() != 0 || offsets.back() != poolSize)
+        return false;
+    for (uint32_t i = 0; i < symbolCount; i++) {
+        if (offsets[i] > offsets[i + 1])
+            return false;
+    }
+    symbols = SymbolTable(std::string(data.substr(pos)), std::move(offsets));
+    for (const auto &record : records) {
+        if ((record.kind >= kinds.size() && record.kind != ERROR_KIND) ||
+            record.symbol >= symbols.size() ||
+            record.offset != symbols.offset(record.symbol) ||
+            record.length != symbols.str(record.symbol).size())
+            return false;
+    }
+    return true;
+}
+
+/* save: write the stream to a file
+ * @return: the file could be written
+ */
+bool TokenStream::save(const std::string &path) const {
+    std::ofstream file(path, std::ios::binary);
+    std::string data = serialize();
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(file);
+}
+
+/* load: read the stream from a file
+ * @return: the file exists and holds a valid stream
+ */
+bool TokenStream::load(const std::string &path) {
+    MappedFile file;
+    if (!file.open(path))
+        return false;
+    return deserialize(file.view());
+}
@@ -0,0 +1,56 @@
+/*
+ * File: tokenStreamWriter.h
+ * Project: Lexer
+ * Author: MingLLuo
+ * Usage: Layout of the binary token stream, shared by TokenStream and the
+ *        generated lexers, which embed this file
+ */
+#ifndef LEXICAL_TOKENSTREAMWRITER_H
+#define LEXICAL_TOKENSTREAMWRITER_H
+
+#include "binaryIO.h"
+#include <vector>
+
+/* TokenRecord: one token, its lexeme is interned as symbol, which is
+ * pool[offset, offset + length) of the symbol table; line counts from 1
+ */
+struct TokenRecord {
+    uint64_t offset;
+    uint32_t kind;
+    uint32_t length;
+    uint32_t line;
+    uint32_t symbol;
+};
+static_assert(sizeof(TokenRecord) == 24, "TokenRecord is stored as is");
+
+inline constexpr char tokenStreamMagic[4] = {'T', 'O', 'K', 'S'};
+inline constexpr uint32_t tokenStreamVersion = 2;
+
+/* writeTokenStream: a stream in binary form, see TokenStream for the layout
+ * @param write: takes (const char *, size_t), called with the pieces in order
+ * @param offsets: symbol count + 1 bounds of the lexemes in pool
+ */
+template <typename Write>
+void writeTokenStream(Write &&write, const std::vector<std::string_view> &kinds,
+                      const std::vector<TokenRecord> &records,
+                      const std::vector<uint32_t> &offsets,
+                      std::string_view pool) {
+    std::string header(tokenStreamMagic, sizeof(tokenStreamMagic));
+    putValue<uint32_t>(header, tokenStreamVersion);
+    putValue<uint32_t>(header, static_cast<uint32_t>(kinds.size()));
+    putValue<uint32_t>(header, static_cast<uint32_t>(offsets.size() - 1));
+    putValue<uint64_t>(header, records.size());
+    putValue<uint64_t>(header, pool.size());
+    for (std::string_view kind : kinds) {
+        putString(header, kind);
+    }
+    header.resize((header.size() + 7) / 8 * 8, '\0');
+    write(header.data(), header.size());
+    write(reinterpret_cast<const char *>(records.data()),
+          records.size() * sizeof(TokenRecord));
+    write(reinterpret_cast<const char *>(offsets.data()),
+          offsets.size() * sizeof(uint32_t));
+    write(pool.data(), pool.size());
+}
+
+#endif // LEXICAL_TOKENSTREAMWRITER_H
@@ -1,10 +0,0 @@
-//
-// Created by MingLLuo on 2023/10/14.
-//
-
-#ifndef LEXICAL_UTIL_H
-#define LEXICAL_UTIL_H
-int fresh();
-
-void flush();
-#endif // LEXICAL_UTIL_H
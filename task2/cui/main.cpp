@@ -1,6 +1,32 @@
 // #include "src/grammar.h"
 #include "src/lr0Parser.h"
+#include "src/mappedFile.h"
 #include "src/slr1Parser.h"
+
+/* parseText: parse the text token format, one "Token: ..." per line
+ * @param path: file written by the lexer
+ */
+static std::shared_ptr<TreeNode> parseText(LR0Parser &parser,
+                                           const std::string &path) {
+  // read from file, lines are split on the mapped contents
+  MappedFile file(path);
+  std::string_view content = file.view();
+  std::vector<std::string> input;
+  while (!content.empty()) {
+    size_t end = content.find('\n');
+    std::string_view line = content.substr(0, end);
+    content.remove_prefix(end == std::string_view::npos ? content.size()
+                                                        : end + 1);
+    if (!line.empty() && line.back() == '\r')
+      line.remove_suffix(1);
+    if (line == "Token: comment" || line.empty()) {
+      continue;
+    }
+    input.emplace_back(line);
+  }
+  return parser.parse(input);
+}
+
 int main() {
   // Pattern p("../bnf.txt");
   // p.printPatterns();
@@ -15,17 +41,14 @@ int main() {
   slr1Parser.printItemSets();
   std::cout << slr1Parser.checkValid() << std::endl;
 
-  // read from file
-  std::ifstream file("../input");
-  std::vector<std::string> input;
-  std::string line;
-  while (std::getline(file, line)) {
-    if (line == "Token: comment" || line.empty()) {
-      continue;
-    }
-    input.push_back(line);
+  // prefer the binary token stream of the lexer, else the text tokens
+  std::shared_ptr<TreeNode> root;
+  TokenStream stream;
+  if (stream.load("../input.bin")) {
+    root = slr1Parser.parse(stream);
+  } else {
+    root = parseText(slr1Parser, "../input");
   }
-  auto root = slr1Parser.parse(input);
   // std::cout << slr1Parser.treeNodePrint(root, 0, "") << std::endl;
 
   if (root) {
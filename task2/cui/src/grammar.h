@@ -8,6 +8,7 @@
 #include <iostream>
 
 #include "pattern.h"
+#include <algorithm>
 #include <sstream>
 #include <unordered_map>
 #include <unordered_set>
@@ -180,16 +180,28 @@ Token LR0Parser::stringToToken(std::string tokenStr) {
   if (tokenStr.substr(0, 2) == "id") {
     // clean the "id -> "
     tokenStr = tokenStr.substr(6);
-    return Token{"identifier", tokenStr};
+    return Token{"identifier", symbolTable.intern(tokenStr)};
   } else if (tokenStr.substr(0, 3) == "num") {
     // clean the "num -> "
     tokenStr = tokenStr.substr(7);
-    return Token{"number", tokenStr};
+    return Token{"number", symbolTable.intern(tokenStr)};
   } else {
-    return Token{tokenStr, ""};
+    return Token{tokenStr};
   }
 }
 
+/**
+ * @brief Text of a tree node, "type -> lexeme" for identifiers and numbers
+ * @param node The node
+ * @return The label
+ */
+std::string LR0Parser::nodeLabel(const TreeNode &node) const {
+  if (node.symbol == SymbolTable::NONE) {
+    return node.value;
+  }
+  return node.value + " -> " + std::string(symbolTable.str(node.symbol));
+}
+
 /**
  * @brief Parse the input tokens
  * @param tokens The input tokens
@@ -201,7 +213,51 @@ std::shared_ptr<TreeNode> LR0Parser::parse(std::vector<std::string> tokens) {
   for (auto &tokenStr : tokens) {
     tokenList.push_back(stringToToken(tokenStr));
   }
+  return parseTokens(tokenList);
+}
+
+/**
+ * @brief Parse a binary token stream, comments are skipped
+ * @param stream The tokens written by the lexer
+ * @return The parse tree
+ */
+std::shared_ptr<TreeNode> LR0Parser::parse(const TokenStream &stream) {
+  // the symbols of the stream become the symbols of the parser
+  symbolTable = stream.symbols;
+  // grammar terminal of every kind, id and num keep their lexeme
+  std::vector<std::string> types;
+  std::vector<bool> hasValue;
+  for (const auto &kind : stream.kinds) {
+    if (kind == "id" || kind == "num") {
+      types.push_back(kind == "id" ? "identifier" : "number");
+      hasValue.push_back(true);
+    } else {
+      types.push_back(kind);
+      hasValue.push_back(false);
+    }
+  }
+
+  std::vector<Token> tokenList;
+  tokenList.reserve(stream.records.size());
+  for (const auto &record : stream.records) {
+    if (record.kind == TokenStream::ERROR_KIND) {
+      tokenList.push_back(Token{"Invalid token", record.symbol});
+    } else if (types[record.kind] != "comment") {
+      tokenList.push_back(
+          Token{types[record.kind],
+                hasValue[record.kind] ? record.symbol : SymbolTable::NONE});
+    }
+  }
+  return parseTokens(tokenList);
+}
 
+/**
+ * @brief Run the SLR table over the tokens
+ * @param tokenList The input tokens, without comments
+ * @return The parse tree
+ */
+std::shared_ptr<TreeNode>
+LR0Parser::parseTokens(const std::vector<Token> &tokenList) {
   std::stack<std::pair<int, std::shared_ptr<TreeNode>>> parseStack;
   auto startNode = std::make_shared<TreeNode>("program");
 
@@ -215,14 +271,17 @@ std::shared_ptr<TreeNode> LR0Parser::parse(std::vector<std::string> tokens) {
     if (idx < tokenList.size()) {
       currentToken = tokenList[idx];
     } else {
-      currentToken = Token{"$", ""};
+      currentToken = Token{"$"};
     }
 
     // --- DEBUG ---
     {
       std::cout << "Current State: " << currentState
                 << ", Current Token: " << currentToken.type << " ('"
-                << currentToken.value << "')" << std::endl;
+                << (currentToken.symbol == SymbolTable::NONE
+                        ? std::string_view()
+                        : symbolTable.str(currentToken.symbol))
+                << "')" << std::endl;
       std::cout << "Stack: \n";
       std::stack<std::pair<int, std::shared_ptr<TreeNode>>>
           tempStack; // temp stack to print the stack
@@ -234,7 +293,7 @@ std::shared_ptr<TreeNode> LR0Parser::parse(std::vector<std::string> tokens) {
         parseStack.push(tempStack.top());
         std::cout << tempStack.top().first;
         if (tempStack.top().second != nullptr) {
-          std::cout << " (" << tempStack.top().second->value << ")";
+          std::cout << " (" << nodeLabel(*tempStack.top().second) << ")";
         }
         std::cout << std::endl;
         tempStack.pop();
@@ -253,13 +312,8 @@ std::shared_ptr<TreeNode> LR0Parser::parse(std::vector<std::string> tokens) {
         transitions[currentState].end()) {
       int nextState = transitions[currentState][currentToken.type];
       std::cout << "**Action: Shift " << nextState << std::endl;
-      std::string value = currentToken.value;
-      if (value == "") {
-        value = currentToken.type;
-      } else {
-        value = currentToken.type + " -> " + value;
-      }
-      parseStack.push({nextState, std::make_shared<TreeNode>(value)});
+      parseStack.push({nextState, std::make_shared<TreeNode>(
+                                      currentToken.type, currentToken.symbol)});
       idx++;
     } else {
       bool reduced = false;
@@ -323,7 +377,7 @@ std::shared_ptr<TreeNode> LR0Parser::parse(std::vector<std::string> tokens) {
       parseStack.push(tempStack.top());
       std::cout << tempStack.top().first;
       if (tempStack.top().second != nullptr) {
-        std::cout << " (" << tempStack.top().second->value << ")";
+        std::cout << " (" << nodeLabel(*tempStack.top().second) << ")";
       }
       std::cout << std::endl;
       tempStack.pop();
@@ -352,7 +406,7 @@ std::string LR0Parser::treeNodePrint(std::shared_ptr<TreeNode> root, int depth,
     ss << "|-";
   }
 
-  ss << root->value << std::endl;
+  ss << nodeLabel(*root) << std::endl;
   for (int i = 0; i < root->children.size(); i++) {
     if (i == root->children.size() - 1) {
       ss << treeNodePrint(root->children[i], depth + 1, prefix + "  ");
@@ -378,20 +432,20 @@ void LR0Parser::generatePseudoCode(std::shared_ptr<TreeNode> &node,
   if (!node->children.empty()) {
     // Add indent
     std::string tempVar = "t" + std::to_string(tempVarCounter++);
-    currentLine = std::string((indentLevel > 1? (indentLevel * 2) : 2), ' ') + tempVar + "(" + node->value + "):= ";
+    currentLine = std::string((indentLevel > 1? (indentLevel * 2) : 2), ' ') + tempVar + "(" + nodeLabel(*node) + "):= ";
     codeList.push_back(currentLine);
     int flag = codeList.size() - 1;
 
     // Now output the current node's assignment to its parent
     if (indentLevel == 0) {
-      codeList.push_back(node->value + " = " + tempVar);
+      codeList.push_back(nodeLabel(*node) + " = " + tempVar);
     } else {
-      codeList.push_back(std::string((indentLevel - 1) * 2, ' ') + node->value +
-                         " = " + tempVar);
+      codeList.push_back(std::string((indentLevel - 1) * 2, ' ') +
+                         nodeLabel(*node) + " = " + tempVar);
     }
       for (auto &child : node->children) {
           if (child->children.empty()) {
-              childResults.push_back(child->value);
+              childResults.push_back(nodeLabel(*child));
           } else {
               tempVar = "t" + std::to_string(tempVarCounter++);
               generatePseudoCode(child, codeList, tempVarCounter, indentLevel + 1);
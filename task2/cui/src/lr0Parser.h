@@ -10,9 +10,10 @@
 #define SLRPARSER_LR0PARSER_H
 
 #include "grammar.h"
-#include "util.h"
+#include "tokenStream.h"
 #include <iostream>
 #include <map>
+#include <memory>
 #include <queue>
 #include <set>
 #include <stack>
@@ -89,15 +90,19 @@ public:
   }
 };
 
+// identifiers and numbers carry their lexeme as a symbol of
+// LR0Parser::symbolTable, other tokens have SymbolTable::NONE
 struct Token {
   std::string type;
-  std::string value;
+  uint32_t symbol = SymbolTable::NONE;
 };
 
 struct TreeNode {
   std::string value;
+  uint32_t symbol = SymbolTable::NONE;
   std::vector<std::shared_ptr<TreeNode>> children;
-  TreeNode(std::string v) : value(v) {}
+  TreeNode(std::string v, uint32_t s = SymbolTable::NONE)
+      : value(std::move(v)), symbol(s) {}
 };
 
 class LR0Parser {
@@ -122,6 +127,8 @@ public:
   ItemSet gotoSet(ItemSet &s, std::string symbol);
 
   std::shared_ptr<TreeNode> parse(std::vector<std::string> tokens);
+  std::shared_ptr<TreeNode> parse(const TokenStream &stream);
+  std::shared_ptr<TreeNode> parseTokens(const std::vector<Token> &tokenList);
   
   void generatePseudoCode(std::shared_ptr<TreeNode> &node,
                           std::vector<std::string> &codeList,
@@ -130,6 +137,7 @@ public:
 
   virtual void printItemSets();
   Token stringToToken(std::string tokenStr);
+  std::string nodeLabel(const TreeNode &node) const;
   std::string itemSetsStr() {
     std::stringstream ss;
     ss << "ItemSet:" << std::endl;
@@ -155,6 +163,8 @@ public:
   std::vector<SingleProduction> productions;
   std::vector<ItemSet> itemSets;
   std::vector<std::string> symbols;
+  // lexemes of identifiers and numbers
+  SymbolTable symbolTable;
   std::unordered_map<int, std::unordered_map<std::string, int>> transitions;
   // initial state
   int startState = 0;
@@ -0,0 +1,88 @@
+/*
+ * File: mappedFile.cpp
+ * Project: Parser
+ * Author: MingLLuo
+ * Usage: Define the MappedFile class
+ */
+#include "mappedFile.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+/* MappedFile: move constructor, other is left closed */
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : mapped(std::exchange(other.mapped, nullptr)),
+      length(std::exchange(other.length, 0)), buffer(std::move(other.buffer)),
+      opened(std::exchange(other.opened, false)) {}
+
+/* operator=: move assignment, the current file is closed first */
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    close();
+    mapped = std::exchange(other.mapped, nullptr);
+    length = std::exchange(other.length, 0);
+    buffer = std::move(other.buffer);
+    opened = std::exchange(other.opened, false);
+  }
+  return *this;
+}
+
+/* open: map or read the file at path, "-" is the standard input
+ * @param path: file path
+ * @return: the file could be opened
+ */
+bool MappedFile::open(const std::string &path) {
+  close();
+  if (path == "-")
+    return openDescriptor(STDIN_FILENO);
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  bool ok = openDescriptor(fd);
+  ::close(fd);
+  return ok;
+}
+
+/* openDescriptor: map or read everything from fd, fd is not closed
+ * @param fd: file descriptor
+ * @return: the file could be read
+ */
+bool MappedFile::openDescriptor(int fd) {
+  close();
+  struct stat st {};
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    void *p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                   MAP_PRIVATE, fd, 0);
+    if (p != MAP_FAILED) {
+      madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+      mapped = static_cast<const char *>(p);
+      length = static_cast<size_t>(st.st_size);
+      opened = true;
+      return true;
+    }
+  }
+
+  // not mappable: read in blocks
+  char block[1 << 16];
+  ssize_t n;
+  while ((n = ::read(fd, block, sizeof(block))) > 0) {
+    buffer.append(block, static_cast<size_t>(n));
+  }
+  if (n < 0)
+    buffer.clear();
+  opened = n == 0;
+  return opened;
+}
+
+/* close: unmap or free the contents */
+void MappedFile::close() {
+  if (mapped != nullptr)
+    munmap(const_cast<char *>(mapped), length);
+  mapped = nullptr;
+  length = 0;
+  buffer.clear();
+  buffer.shrink_to_fit();
+  opened = false;
+}
@@ -5,19 +5,15 @@
  * Usage: Define the Pattern class
  */
 #include "pattern.h"
+#include "mappedFile.h"
 
 /* loadPatterns: read file and call readPatterns
  * @param filePath: file path
  */
 void Pattern::loadPatterns(const std::string &filePath) {
   // readfile then readPatterns
-  std::ifstream file(filePath);
-  std::string content;
-  std::string line;
-  while (std::getline(file, line)) {
-    content += line + "\n";
-  }
-  readPatterns(content);
+  MappedFile file(filePath);
+  readPatterns(std::string(file.view()));
 }
 
 /* readPatterns: read patterns from string, if 'rules' exists, read rules till
@@ -0,0 +1,138 @@
+/*
+ * File: tokenStream.cpp
+ * Project: Parser
+ * Author: MingLLuo
+ * Usage: Define the TokenStream class
+ */
+#include "tokenStream.h"
+#include "mappedFile.h"
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+static const char magic[4] = {'T', 'O', 'K', 'S'};
+static_assert(sizeof(TokenRecord) == 24, "TokenRecord is stored as is");
+
+/* add: append a token, its lexeme is interned
+ * @param kind: index in kinds, or ERROR_KIND
+ * @param line: line of the first byte of the token
+ */
+void TokenStream::add(uint32_t kind, uint32_t line, std::string_view lexeme) {
+  uint32_t symbol = symbols.intern(lexeme);
+  records.push_back({symbols.offset(symbol), kind,
+                     static_cast<uint32_t>(lexeme.size()), line, symbol});
+}
+
+/* putValue: append the bytes of value to out */
+template <typename T> static void putValue(std::string &out, T value) {
+  out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+/* getValue: read a T at pos of data and move pos past it
+ * @return: false if data is too short
+ */
+template <typename T>
+static bool getValue(std::string_view data, size_t &pos, T &value) {
+  if (data.size() - pos < sizeof(T))
+    return false;
+  std::memcpy(&value, data.data() + pos, sizeof(T));
+  pos += sizeof(T);
+  return true;
+}
+
+/* serialize: the stream in binary form */
+std::string TokenStream::serialize() const {
+  std::string out;
+  out.append(magic, sizeof(magic));
+  putValue<uint32_t>(out, version);
+  putValue<uint32_t>(out, static_cast<uint32_t>(kinds.size()));
+  putValue<uint32_t>(out, static_cast<uint32_t>(symbols.size()));
+  putValue<uint64_t>(out, records.size());
+  putValue<uint64_t>(out, symbols.data().size());
+  for (const auto &kind : kinds) {
+    putValue<uint32_t>(out, static_cast<uint32_t>(kind.size()));
+    out += kind;
+  }
+  out.resize((out.size() + 7) / 8 * 8, '\0');
+  out.append(reinterpret_cast<const char *>(records.data()),
+             records.size() * sizeof(TokenRecord));
+  out.append(reinterpret_cast<const char *>(symbols.bounds().data()),
+             symbols.bounds().size() * sizeof(uint32_t));
+  out += symbols.data();
+  return out;
+}
+
+/* deserialize: replace the stream with the one stored in data
+ * @return: false if data is not a valid stream of this version
+ */
+bool TokenStream::deserialize(std::string_view data) {
+  kinds.clear();
+  records.clear();
+  symbols = SymbolTable();
+  size_t pos = 0;
+  uint32_t fileVersion, kindCount, symbolCount;
+  uint64_t recordCount, poolSize;
+  if (data.substr(0, sizeof(magic)) != std::string_view(magic, sizeof(magic)))
+    return false;
+  pos += sizeof(magic);
+  if (!getValue(data, pos, fileVersion) || fileVersion != version ||
+      !getValue(data, pos, kindCount) || !getValue(data, pos, symbolCount) ||
+      !getValue(data, pos, recordCount) || !getValue(data, pos, poolSize))
+    return false;
+  for (uint32_t i = 0; i < kindCount; i++) {
+    uint32_t length;
+    if (!getValue(data, pos, length) || data.size() - pos < length)
+      return false;
+    kinds.emplace_back(data.substr(pos, length));
+    pos += length;
+  }
+  pos = (pos + 7) / 8 * 8;
+  uint64_t offsetsSize = (uint64_t{symbolCount} + 1) * sizeof(uint32_t);
+  if (pos > data.size() ||
+      (data.size() - pos) / sizeof(TokenRecord) < recordCount ||
+      data.size() - pos - recordCount * sizeof(TokenRecord) !=
+          offsetsSize + poolSize)
+    return false;
+  records.resize(recordCount);
+  std::memcpy(records.data(), data.data() + pos,
+              recordCount * sizeof(TokenRecord));
+  pos += recordCount * sizeof(TokenRecord);
+  std::vector<uint32_t> offsets(symbolCount + 1);
+  std::memcpy(offsets.data(), data.data() + pos, offsetsSize);
+  pos += offsetsSize;
+  if (offsets.front() != 0 || offsets.back() != poolSize)
+    return false;
+  for (uint32_t i = 0; i < symbolCount; i++) {
+    if (offsets[i] > offsets[i + 1])
+      return false;
+  }
+  symbols = SymbolTable(std::string(data.substr(pos)), std::move(offsets));
+  for (const auto &record : records) {
+    if ((record.kind >= kinds.size() && record.kind != ERROR_KIND) ||
+        record.symbol >= symbols.size() ||
+        record.offset != symbols.offset(record.symbol) ||
+        record.length != symbols.str(record.symbol).size())
+      return false;
+  }
+  return true;
+}
+
+/* save: write the stream to a file
+ * @return: the file could be written
+ */
+bool TokenStream::save(const std::string &path) const {
+  std::ofstream file(path, std::ios::binary);
+  std::string data = serialize();
+  file.write(data.data(), static_cast<std::streamsize>(data.size()));
+  return static_cast<bool>(file);
+}
+
+/* load: read the stream from a file
+ * @return: the file exists and holds a valid stream
+ */
+bool TokenStream::load(const std::string &path) {
+  MappedFile file;
+  if (!file.open(path))
+    return false;
+  return deserialize(file.view());
+}
@@ -0,0 +1,60 @@
+/*
+ * File: tokenStream.h
+ * Project: Parser
+ * Author: MingLLuo
+ * Usage: Define the TokenStream class, binary token format read by the parser
+ */
+#ifndef SLRPARSER_TOKENSTREAM_H
+#define SLRPARSER_TOKENSTREAM_H
+
+#include "symbolTable.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* TokenRecord: one token, its lexeme is interned as symbol, which is
+ * pool[offset, offset + length) of the symbol table; line counts from 1
+ */
+struct TokenRecord {
+  uint64_t offset;
+  uint32_t kind;
+  uint32_t length;
+  uint32_t line;
+  uint32_t symbol;
+};
+
+/* TokenStream: tokens in the binary format shared by the lexer and the
+ * parser, all numbers in host byte order:
+ *   header    "TOKS", uint32 version, uint32 kind count,
+ *             uint32 symbol count, uint64 record count, uint64 pool size
+ *   kinds     uint32 length + name, for every kind
+ *   padding   zeros up to a multiple of 8
+ *   records   TokenRecord[record count]
+ *   symbols   uint32 offsets[symbol count + 1] into the pool
+ *   pool      every distinct lexeme once
+ * kind indexes kinds, or is ERROR_KIND for an invalid byte
+ */
+class TokenStream {
+public:
+  static constexpr uint32_t ERROR_KIND = UINT32_MAX;
+  static constexpr uint32_t version = 2;
+
+  std::vector<std::string> kinds;
+  std::vector<TokenRecord> records;
+  SymbolTable symbols;
+
+  void add(uint32_t kind, uint32_t line, std::string_view lexeme);
+
+  [[nodiscard]] std::string_view lexeme(const TokenRecord &record) const {
+    return symbols.str(record.symbol);
+  }
+
+  [[nodiscard]] std::string serialize() const;
+  bool deserialize(std::string_view data);
+
+  bool save(const std::string &path) const;
+  bool load(const std::string &path);
+};
+
+#endif // SLRPARSER_TOKENSTREAM_H
@@ -1,4 +1,6 @@
 #include "util.h"
-static int fresh_counter = 0;
+// one counter per thread: automata built on different threads never share
+// it, a construction still flushes only its own thread's counter
+static thread_local int fresh_counter = 0;
 int fresh() { return ++fresh_counter; }
 void flush() { fresh_counter = 0; }
\ No newline at end of file